@@ -37,23 +37,37 @@
 #define LCD_X	240
 #define LCD_Y	320
 
-//#define PORTRAIT or LANDSCAPE
+// Orientation after initialization, can be changed at runtime with Adafruit320x240x16_ILI9325RotationSet
+//#define PORTRAIT, LANDSCAPE, PORTRAIT_FLIP or LANDSCAPE_FLIP
 #define LANDSCAPE
 
-// Logical dimensions of LCD
-#ifdef PORTRAIT
-#define LCD_WIDTH	LCD_X
-#define LCD_HEIGHT	LCD_Y
+#if defined(PORTRAIT)
+#define LCD_ROTATION_DEFAULT	ADAFRUIT_ILI9325_PORTRAIT
+#elif defined(PORTRAIT_FLIP)
+#define LCD_ROTATION_DEFAULT	ADAFRUIT_ILI9325_PORTRAIT_FLIP
+#elif defined(LANDSCAPE_FLIP)
+#define LCD_ROTATION_DEFAULT	ADAFRUIT_ILI9325_LANDSCAPE_FLIP
 #else
-#define LCD_WIDTH	LCD_Y
-#define LCD_HEIGHT	LCD_X
+#define LCD_ROTATION_DEFAULT	ADAFRUIT_ILI9325_LANDSCAPE
 #endif
 
-// Port and bitmask used for 8-bit data bus
+// Uncomment to use the 16-bit 80-system interface instead of the 8-bit one
+// The IM pins of the controller must select the 16-bit interface
+//#define LCD_BUS_16BIT
+
+// Port and bitmask used for 8-bit data bus, or lower byte of 16-bit data bus
 #define LCD_DATA_PERIPH			SYSCTL_PERIPH_GPIOB
 #define LCD_DATA_BASE			GPIO_PORTB_BASE
 #define LCD_DATA_PINS			0xFF
 
+// Port and bitmask used for higher byte of 16-bit data bus, on pins 0 to 7
+// On LM4F120 pin D.7 is locked as NMI and must be unlocked before Adafruit320x240x16_ILI9325Init
+#ifdef LCD_BUS_16BIT
+#define LCD_DATA_HIGH_PERIPH	SYSCTL_PERIPH_GPIOD
+#define LCD_DATA_HIGH_BASE		GPIO_PORTD_BASE
+#define LCD_DATA_HIGH_PINS		0xFF
+#endif
+
 // Ports and pins used for control
 #define LCD_CS_PERIPH			SYSCTL_PERIPH_GPIOA
 #define LCD_CS_BASE				GPIO_PORTA_BASE
@@ -91,10 +105,60 @@
 #define LCD_BKLT_ON				HWREG(LCD_BKLT_BASE + GPIO_O_DATA + (LCD_BKLT_PIN << 2)) = LCD_BKLT_PIN;
 #define LCD_BKLT_OFF			HWREG(LCD_BKLT_BASE + GPIO_O_DATA + (LCD_BKLT_PIN << 2)) = 0;
 #define LCD_DATA_WRITE(ucByte)	{ HWREG(LCD_DATA_BASE + GPIO_O_DATA + (LCD_DATA_PINS << 2)) = (ucByte); }
+#ifdef LCD_BUS_16BIT
+#define LCD_DATA_HIGH_WRITE(ucByte)	{ HWREG(LCD_DATA_HIGH_BASE + GPIO_O_DATA + (LCD_DATA_HIGH_PINS << 2)) = (ucByte); }
+#endif
+
+// Macros combining several control pin changes into one store
+// Only possible if CS, C/D, WR and RD share a port, otherwise fall back to one store per pin
+#if (LCD_CS_BASE == LCD_CD_BASE) && (LCD_CD_BASE == LCD_WR_BASE) && (LCD_WR_BASE == LCD_RD_BASE)
+#define LCD_CTRL_BASE			LCD_CS_BASE
+#define LCD_CTRL_WRITE(ucPins, ucValue)	HWREG(LCD_CTRL_BASE + GPIO_O_DATA + ((ucPins) << 2)) = (ucValue);
+#define LCD_CTRL_IDLE			LCD_CTRL_WRITE(LCD_CS_PIN | LCD_WR_PIN | LCD_RD_PIN, LCD_CS_PIN | LCD_WR_PIN | LCD_RD_PIN)
+#define LCD_CD_DATA_WR_ACTIVE	LCD_CTRL_WRITE(LCD_CD_PIN | LCD_WR_PIN, LCD_CD_PIN)
+#define LCD_CD_COMMAND_WR_ACTIVE	LCD_CTRL_WRITE(LCD_CD_PIN | LCD_WR_PIN, 0)
+#else
+#define LCD_CTRL_IDLE			LCD_CS_IDLE LCD_WR_IDLE LCD_RD_IDLE
+#define LCD_CD_DATA_WR_ACTIVE	LCD_CD_DATA LCD_WR_ACTIVE
+#define LCD_CD_COMMAND_WR_ACTIVE	LCD_CD_COMMAND LCD_WR_ACTIVE
+#endif
+
+// Macros to strobe WR, the data byte is latched by the display on the rising edge
+// Above LCD_WR_HOLD_CLOCK the hold variant keeps WR low for an additional store
+#define LCD_WR_HOLD_CLOCK		50000000
+#define LCD_WR_STROBE			{ LCD_WR_ACTIVE LCD_WR_IDLE }
+#define LCD_WR_STROBE_HOLD		{ LCD_WR_ACTIVE LCD_WR_ACTIVE LCD_WR_IDLE }
+
+// Macros to write one word already split into bus bytes inside a data burst, C/D must already be set to data
+// Only the bits of LCD_DATA_PINS are written, so bytes need not be masked
+#ifdef LCD_BUS_16BIT
+#define LCD_BURST_BYTES_FAST(ucHigh, ucLow)	{ LCD_DATA_HIGH_WRITE(ucHigh); LCD_DATA_WRITE(ucLow); LCD_WR_STROBE }
+#define LCD_BURST_BYTES_HOLD(ucHigh, ucLow)	{ LCD_DATA_HIGH_WRITE(ucHigh); LCD_DATA_WRITE(ucLow); LCD_WR_STROBE_HOLD }
+#else
+#define LCD_BURST_BYTES_FAST(ucHigh, ucLow)	{ LCD_DATA_WRITE(ucHigh); LCD_WR_STROBE LCD_DATA_WRITE(ucLow); LCD_WR_STROBE }
+#define LCD_BURST_BYTES_HOLD(ucHigh, ucLow)	{ LCD_DATA_WRITE(ucHigh); LCD_WR_STROBE_HOLD LCD_DATA_WRITE(ucLow); LCD_WR_STROBE_HOLD }
+#endif
+#define LCD_BURST_BYTES(ucHigh, ucLow)	{ if(g_bWrHold) LCD_BURST_BYTES_HOLD(ucHigh, ucLow) else LCD_BURST_BYTES_FAST(ucHigh, ucLow) }
+
+// Macros to write one 16 bit word inside a data burst
+#define LCD_BURST_WRITE_FAST(usData)	LCD_BURST_BYTES_FAST((usData) >> 8, (usData) & 0xff)
+#define LCD_BURST_WRITE_HOLD(usData)	LCD_BURST_BYTES_HOLD((usData) >> 8, (usData) & 0xff)
+#define LCD_BURST_WRITE(usData)	LCD_BURST_BYTES((usData) >> 8, (usData) & 0xff)
+
+// All controller registers are below 0x100, so the high byte of a command is constant
+#define LCD_COMMAND_HIGH		0x00
 
 // Macro to wait x ms
 #define LCD_DELAY(x)			{ SysCtlDelay((x) * (g_ulWait1ms)); }
 
+// Read access, data port is switched to input while reading
+// RD low and high phases are held for about 250 ns, longer than the read cycle of the controller needs
+#define LCD_DATA_READ			HWREG(LCD_DATA_BASE + GPIO_O_DATA + (LCD_DATA_PINS << 2))
+#ifdef LCD_BUS_16BIT
+#define LCD_DATA_HIGH_READ		HWREG(LCD_DATA_HIGH_BASE + GPIO_O_DATA + (LCD_DATA_HIGH_PINS << 2))
+#endif
+#define LCD_READ_DELAY			{ SysCtlDelay(g_ulReadDelay); }
+
 // display controller register names from Peter Barrett's / Adafruit's Microtouch code
 #define ILI_START_OSC 0x00
 #define ILI_DRIV_OUT_CTRL 0x01
@@ -147,6 +211,25 @@
 #define ILI_PANEL_IF_CTRL5 0x97
 #define ILI_PANEL_IF_CTRL6 0x98
 
+// Entry modes used by the driver: horizontal or vertical write direction, both incrementing
+#define ILI_ENTRY_MOD_HOR 0x1030
+#define ILI_ENTRY_MOD_VER 0x1038
+
+// Bits of entry mode register
+#define ILI_ENTRY_MOD_AM 0x0008
+#define ILI_ENTRY_MOD_ID0 0x0010
+#define ILI_ENTRY_MOD_ID1 0x0020
+
+// Bits of output control registers selecting scan direction
+#define ILI_DRIV_OUT_CTRL_SS 0x0100
+#define ILI_GATE_SCAN_CTRL1_GS 0x8000
+#define ILI_GATE_SCAN_CTRL1_320 0x2700
+
+// Bits of display control register enabling base and partial images
+#define ILI_DISP_CTRL1_BASEE 0x0100
+#define ILI_DISP_CTRL1_PTDE0 0x1000
+#define ILI_DISP_CTRL1_PTDE1 0x2000
+
 // Fake commands for display initialization script
 #define ILI_DELAYCMD 0xFF
 #define ILI_STOPCMD 0xFE
@@ -158,7 +241,7 @@ static const unsigned short usInitScript[] =
 	ILI_DELAYCMD, 50, // this will make a delay of 50 milliseconds
 	ILI_DRIV_OUT_CTRL, 0x0100,
 	ILI_DRIV_WAV_CTRL, 0x0700,
-	ILI_ENTRY_MOD, 0x1030,
+	ILI_ENTRY_MOD, ILI_ENTRY_MOD_HOR,
 	ILI_RESIZE_CTRL, 0x0000,
 	ILI_DISP_CTRL2, 0x0202,
 	ILI_DISP_CTRL3, 0x0000,
@@ -210,392 +293,2065 @@ static const unsigned short usInitScript[] =
 	ILI_STOPCMD
 };
 
-static const tRectangle g_FullScreen = { 0, 0, LCD_WIDTH-1, LCD_HEIGHT-1 };
+// Full GRAM in GRAM coordinates, X is the horizontal and Y the vertical address
+static const tRectangle g_FullScreen = { 0, 0, LCD_X-1, LCD_Y-1 };
+
+// Active address window of controller in GRAM coordinates, empty if unknown
+tRectangle g_sWindow;
+
+// Active orientation
+unsigned long g_ulRotation;
+
+// Hardware scroll offset in lines along the 320 line axis
+unsigned long g_ulScroll;
+
+// Display control register, holds enable bits of base and partial images
+unsigned short g_usDisplayControl;
+
+// Progress of display initialization
+#define LCD_INIT_IDLE			0	// not started
+#define LCD_INIT_RESET			1	// reset asserted
+#define LCD_INIT_SYNC			2	// reset released, controller starting up
+#define LCD_INIT_SCRIPT			3	// processing usInitScript
+#define LCD_INIT_CLEAR			4	// clearing GRAM
+#define LCD_INIT_DONE			5
+// Lines of GRAM cleared per tick, LCD_Y must be a multiple
+#define LCD_INIT_CLEAR_LINES	32
+unsigned long g_ulInitState;
+// Milliseconds left before the next step
+unsigned long g_ulInitWait;
+// Index into usInitScript or first line to clear
+unsigned long g_ulInitPos;
+tILI9325InitCallback g_pfnInitDone;
+
+// Batched mode keeps CS asserted across primitives until flush or ulMaxOps primitives
+tBoolean g_bBatch;
+tBoolean g_bSessionOpen;
+unsigned long g_ulBatchOps;
+unsigned long g_ulBatchMaxOps;
 
 // SysCtlDelay loops for 1 ms wait
 unsigned long g_ulWait1ms;
-unsigned short g_usPosX;
-unsigned short g_usPosY;
+// WR strobes need an additional hold store at the current system clock
+tBoolean g_bWrHold;
+// SysCtlDelay loops for each phase of an RD strobe
+unsigned long g_ulReadDelay;
+// Index register of controller, writes to GRAM continue without new command while this is ILI_RW_GRAM
+unsigned char g_ucIndex;
+
+// Cache of palettes translated to display colors, split into the bytes sent on the bus
+// RAM used is LCD_PALETTE_CACHE_SLOTS * 516 bytes
+#define LCD_PALETTE_CACHE_SLOTS	2
+typedef struct
+{
+	const unsigned char *pucPalette;	// untranslated palette, 0 if slot is unused
+	unsigned long ulEntries;			// number of translated entries
+	unsigned char pucHigh[256];			// high byte of display color
+	unsigned char pucLow[256];			// low byte of display color
+} tLCDPalette;
+static tLCDPalette g_psPaletteCache[LCD_PALETTE_CACHE_SLOTS];
+static unsigned long g_ulPaletteNext;
+
+// Cache of glyphs expanded to display colors for Adafruit320x240x16_ILI9325StringDraw
+// Glyphs are stored in an arena of LCD_GLYPH_CACHE_PIXELS pixels in the order of g_psGlyphs, the least
+// recently used glyph is removed and the glyphs behind it moved down until a new one fits.
+// RAM used is 2 bytes per pixel plus 16 bytes per entry
+#define LCD_GLYPH_CACHE_PIXELS	2048
+#define LCD_GLYPH_CACHE_ENTRIES	32
+typedef struct
+{
+	const tFont *pFont;
+	unsigned short usForeground;		// display colors the glyph was expanded with
+	unsigned short usBackground;
+	unsigned char ucChar;
+	unsigned char ucWidth;
+	unsigned short usOffset;			// first pixel in arena
+	unsigned long ulUsed;				// value of g_ulGlyphClock when last drawn
+} tLCDGlyph;
+static tLCDGlyph g_psGlyphs[LCD_GLYPH_CACHE_ENTRIES];
+static unsigned long g_ulGlyphCount;
+static unsigned long g_ulGlyphPixels;	// pixels of arena in use
+static unsigned long g_ulGlyphClock;
+static unsigned long g_ulGlyphHits;
+static unsigned long g_ulGlyphMisses;
+static unsigned short g_pusGlyphArena[LCD_GLYPH_CACHE_PIXELS];
+
+// Buffer for pixels read back by Adafruit320x240x16_ILI9325RectCopy, RAM used is 2 bytes per pixel
+#define LCD_COPY_PIXELS			320
+static unsigned short g_pusCopy[LCD_COPY_PIXELS];
+
+// Bus bytes of the 4 pixels of every nibble of 1 bit per pixel data and the colors they were built for
+static unsigned char g_pucNibble[16][8];
+static unsigned long g_ulNibbleBackground = 0xffffffff;
+static unsigned long g_ulNibbleForeground = 0xffffffff;
+
+// Start of last multi pixel row, used to detect rows of an image
+long g_lRowX;
+long g_lRowY;
+long g_lRowCount;
+
+// Shadow copy of the controller registers the driver writes while drawing
+// Writes of an unchanged value are skipped, LCD_SHADOW_INVALID forces the next write
+// The GRAM address is advanced after every burst to follow the address counter of the controller
+#define LCD_SHADOW_INVALID		0xFFFF
+#define LCD_SHADOW_ENTRY_MOD	0
+#define LCD_SHADOW_GRAM_HOR_AD	1
+#define LCD_SHADOW_GRAM_VER_AD	2
+#define LCD_SHADOW_HOR_START_AD	3
+#define LCD_SHADOW_HOR_END_AD	4
+#define LCD_SHADOW_VER_START_AD	5
+#define LCD_SHADOW_VER_END_AD	6
+#define LCD_SHADOW_COUNT		7
+static unsigned short g_pusShadow[LCD_SHADOW_COUNT];
 
 void LCDWriteData(const unsigned short usData)
 {
-	LCD_CD_DATA
-
-	// Send higher byte
+#ifdef LCD_BUS_16BIT
+	// Put word on the bus, then switch to data mode and pull WR low in one store
+	LCD_DATA_HIGH_WRITE(usData >> 8);
+	LCD_DATA_WRITE(usData & 0xff);
+	LCD_CD_DATA_WR_ACTIVE
+	if(g_bWrHold)
+	{
+		LCD_WR_ACTIVE
+	}
+	LCD_WR_IDLE
+#else
+	// Switch to data mode and pull WR low in one store, then send higher byte
+	// The data store keeps WR low long enough for any clock speed
+	LCD_CD_DATA_WR_ACTIVE
 	LCD_DATA_WRITE(usData >> 8);
-
-	// Strobe WR
-	LCD_WR_ACTIVE
 	LCD_WR_IDLE
 
 	// Send lower byte
 	LCD_DATA_WRITE(usData & 0xff);
+	if(g_bWrHold)
+	{
+		LCD_WR_STROBE_HOLD
+	}
+	else
+	{
+		LCD_WR_STROBE
+	}
+#endif
+}
 
-	// Strobe WR
-	LCD_WR_ACTIVE
+void LCDWriteCommand(const unsigned char ucAddress)
+{
+	g_ucIndex = ucAddress;
+
+#ifdef LCD_BUS_16BIT
+	// Put command on the bus, then switch to command mode and pull WR low in one store
+	LCD_DATA_HIGH_WRITE(LCD_COMMAND_HIGH);
+	LCD_DATA_WRITE(ucAddress);
+	LCD_CD_COMMAND_WR_ACTIVE
+	if(g_bWrHold)
+	{
+		LCD_WR_ACTIVE
+	}
+	LCD_WR_IDLE
+#else
+	// Switch to command mode and pull WR low in one store, then send constant higher byte
+	LCD_CD_COMMAND_WR_ACTIVE
+	LCD_DATA_WRITE(LCD_COMMAND_HIGH);
 	LCD_WR_IDLE
+
+	// Send lower byte
+	LCD_DATA_WRITE(ucAddress);
+	if(g_bWrHold)
+	{
+		LCD_WR_STROBE_HOLD
+	}
+	else
+	{
+		LCD_WR_STROBE
+	}
+#endif
+}
+
+// Returns index of register in shadow copy, or -1 if the register is not shadowed
+static int LCDShadowIndex(const unsigned char ucAddress)
+{
+	switch(ucAddress)
+	{
+	case ILI_ENTRY_MOD:		return LCD_SHADOW_ENTRY_MOD;
+	case ILI_GRAM_HOR_AD:	return LCD_SHADOW_GRAM_HOR_AD;
+	case ILI_GRAM_VER_AD:	return LCD_SHADOW_GRAM_VER_AD;
+	case ILI_HOR_START_AD:	return LCD_SHADOW_HOR_START_AD;
+	case ILI_HOR_END_AD:	return LCD_SHADOW_HOR_END_AD;
+	case ILI_VER_START_AD:	return LCD_SHADOW_VER_START_AD;
+	case ILI_VER_END_AD:	return LCD_SHADOW_VER_END_AD;
+	default:				return -1;
+	}
 }
 
-void LCDWriteCommand(const unsigned short usAddress)
+// Write controller register, skipped if the shadow copy shows it already holds usData
+void LCDWriteRegister(const unsigned char ucAddress, const unsigned short usData)
 {
-	LCD_CD_COMMAND
+	int iShadow = LCDShadowIndex(ucAddress);
 
-	// Send higher byte
-	LCD_DATA_WRITE(usAddress >> 8);
+	if(iShadow >= 0)
+	{
+		if(g_pusShadow[iShadow] == usData)
+		{
+			return;
+		}
+		g_pusShadow[iShadow] = usData;
+	}
 
-	// Strobe WR
-	LCD_WR_ACTIVE
-	LCD_WR_IDLE
+	LCDWriteCommand(ucAddress);
+	LCDWriteData(usData);
+}
 
-	// Send lower byte
-	LCD_DATA_WRITE(usAddress & 0xff);
+// Forget shadow copy of controller registers, e.g. after reset or access by other code
+void Adafruit320x240x16_ILI9325CacheInvalidate(void)
+{
+	int i;
 
-	// Strobe WR
-	LCD_WR_ACTIVE
-	LCD_WR_IDLE
+	for(i = 0; i < LCD_SHADOW_COUNT; i++)
+	{
+		g_pusShadow[i] = LCD_SHADOW_INVALID;
+	}
+	g_ucIndex = ILI_STOPCMD;
+	g_lRowCount = 0;
+	g_sWindow.sXMin = 0;
+	g_sWindow.sYMin = 0;
+	g_sWindow.sXMax = -1;
+	g_sWindow.sYMax = -1;
 }
 
-// Coordinates of next display write
-void LCDGoto(unsigned short x, unsigned short y)
+// Advance shadow copy of GRAM address by the number of words written
+// Follows the address counter of the controller through the active window in
+// the direction configured by the entry mode
+static void LCDCursorAdvance(unsigned long ulCount)
 {
-	if(x >= LCD_WIDTH) x = LCD_WIDTH - 1;
-	if(y >= LCD_HEIGHT) y = LCD_HEIGHT - 1;
+	unsigned short usEntryMode = g_pusShadow[LCD_SHADOW_ENTRY_MOD];
+	unsigned short usH = g_pusShadow[LCD_SHADOW_GRAM_HOR_AD];
+	unsigned short usV = g_pusShadow[LCD_SHADOW_GRAM_VER_AD];
+	unsigned short usHStart = g_pusShadow[LCD_SHADOW_HOR_START_AD];
+	unsigned short usHEnd = g_pusShadow[LCD_SHADOW_HOR_END_AD];
+	unsigned short usVStart = g_pusShadow[LCD_SHADOW_VER_START_AD];
+	unsigned short usVEnd = g_pusShadow[LCD_SHADOW_VER_END_AD];
+	unsigned long ulHOffset, ulVOffset, ulWidth, ulHeight, ulPos;
+
+	if((usEntryMode == LCD_SHADOW_INVALID) || (usH < usHStart) || (usH > usHEnd) ||
+	   (usV < usVStart) || (usV > usVEnd) || (usHEnd == LCD_SHADOW_INVALID) || (usVEnd == LCD_SHADOW_INVALID))
+	{
+		// Position of address counter unknown, force next LCDGoto to set it
+		g_pusShadow[LCD_SHADOW_GRAM_HOR_AD] = LCD_SHADOW_INVALID;
+		g_pusShadow[LCD_SHADOW_GRAM_VER_AD] = LCD_SHADOW_INVALID;
+		return;
+	}
 
-#ifdef PORTRAIT
-	LCDWriteCommand(ILI_GRAM_HOR_AD);	// GRAM Address Set (Horizontal Address) (R20h)
-	LCDWriteData(x);
-	LCDWriteCommand(ILI_GRAM_VER_AD);	// GRAM Address Set (Vertical Address) (R21h)
-	LCDWriteData(y);
-	LCDWriteCommand(ILI_RW_GRAM);		// Write Data to GRAM (R22h)
-#else
-	LCDWriteCommand(ILI_GRAM_HOR_AD);	// GRAM Address Set (Horizontal Address) (R20h)
-	LCDWriteData(LCD_X - y);
-	LCDWriteCommand(ILI_GRAM_VER_AD);	// GRAM Address Set (Vertical Address) (R21h)
-	LCDWriteData(x);
-	LCDWriteCommand(ILI_RW_GRAM);		// Write Data to GRAM (R22h)
-#endif
+	// Offset of address counter from the window corner it starts at
+	ulWidth = usHEnd - usHStart + 1;
+	ulHeight = usVEnd - usVStart + 1;
+	ulHOffset = (usEntryMode & ILI_ENTRY_MOD_ID0) ? usH - usHStart : usHEnd - usH;
+	ulVOffset = (usEntryMode & ILI_ENTRY_MOD_ID1) ? usV - usVStart : usVEnd - usV;
+
+	// Move along the primary direction and wrap to the next line, or back to the start of the window
+	if(usEntryMode & ILI_ENTRY_MOD_AM)
+	{
+		ulPos = (ulHOffset * ulHeight + ulVOffset + ulCount) % (ulWidth * ulHeight);
+		ulHOffset = ulPos / ulHeight;
+		ulVOffset = ulPos % ulHeight;
+	}
+	else
+	{
+		ulPos = (ulVOffset * ulWidth + ulHOffset + ulCount) % (ulWidth * ulHeight);
+		ulVOffset = ulPos / ulWidth;
+		ulHOffset = ulPos % ulWidth;
+	}
+
+	g_pusShadow[LCD_SHADOW_GRAM_HOR_AD] = (usEntryMode & ILI_ENTRY_MOD_ID0) ? usHStart + ulHOffset : usHEnd - ulHOffset;
+	g_pusShadow[LCD_SHADOW_GRAM_VER_AD] = (usEntryMode & ILI_ENTRY_MOD_ID1) ? usVStart + ulVOffset : usVEnd - ulVOffset;
+}
 
-	g_usPosX = x;
-	g_usPosY = y;
+// Start a burst of data words, C/D is switched only once for the whole burst
+void LCDBurstBegin(void)
+{
+	LCD_CD_DATA
 }
 
-// Clear display
-void LCDClear(void)
+// Strobe WR ulCount times without changing the data on the bus
+static inline void LCDStrobeRepeat(unsigned long ulCount)
 {
-	LCDGoto(0, 0);
-	int i = 0;
-	while(i < LCD_WIDTH * LCD_HEIGHT)
+	if(g_bWrHold)
+	{
+		while(ulCount >= 4)
+		{
+			LCD_WR_STROBE_HOLD LCD_WR_STROBE_HOLD LCD_WR_STROBE_HOLD LCD_WR_STROBE_HOLD
+			ulCount -= 4;
+		}
+		while(ulCount)
+		{
+			LCD_WR_STROBE_HOLD
+			ulCount--;
+		}
+	}
+	else
 	{
-		LCDWriteData(0);	// Write black pixel
-		i++;
+		while(ulCount >= 8)
+		{
+			LCD_WR_STROBE LCD_WR_STROBE LCD_WR_STROBE LCD_WR_STROBE
+			LCD_WR_STROBE LCD_WR_STROBE LCD_WR_STROBE LCD_WR_STROBE
+			ulCount -= 8;
+		}
+		while(ulCount)
+		{
+			LCD_WR_STROBE
+			ulCount--;
+		}
 	}
 }
 
-// Configure display controller to write to defined display area
-void LCDAddressWindow(const tRectangle *pRect)
+// Write ulCount copies of usData within a burst
+// This is the run fill engine used by all constant color primitives. It only
+// stores to the data port when the byte on the bus actually changes.
+void LCDBurstRepeat(const unsigned short usData, unsigned long ulCount)
 {
-#ifdef PORTRAIT
-	LCDWriteCommand(ILI_HOR_START_AD);
-	LCDWriteData(pRect->sXMin);
-	LCDWriteCommand(ILI_HOR_END_AD);
-	LCDWriteData(pRect->sXMax);
-	LCDWriteCommand(ILI_VER_START_AD);
-	LCDWriteData(pRect->sYMin);
-	LCDWriteCommand(ILI_VER_END_AD);
-	LCDWriteData(pRect->sYMax);
+	unsigned char ucHigh = usData >> 8;
+	unsigned char ucLow = usData & 0xff;
+
+#ifdef LCD_BUS_16BIT
+	// Whole color is on the bus at once, set data ports once and only strobe WR
+	LCD_DATA_HIGH_WRITE(ucHigh);
+	LCD_DATA_WRITE(ucLow);
+	LCDStrobeRepeat(ulCount);
 #else
-	LCDWriteCommand(ILI_HOR_START_AD);
-	LCDWriteData(LCD_X - pRect->sYMax);
-	LCDWriteCommand(ILI_HOR_END_AD);
-	LCDWriteData(LCD_X - pRect->sYMin);
-	LCDWriteCommand(ILI_VER_START_AD);
-	LCDWriteData(pRect->sXMin);
-	LCDWriteCommand(ILI_VER_END_AD);
-	LCDWriteData(pRect->sXMax);
+	if(ucHigh == ucLow)
+	{
+		// Both bytes are equal (e.g. black, white, greys), set data port once and only strobe WR
+		LCD_DATA_WRITE(ucHigh);
+		LCDStrobeRepeat(ulCount << 1);	// 2 strobes per pixel
+	}
+	else if(g_bWrHold)
+	{
+		// Alternate between the 2 bytes of the color
+		while(ulCount >= 2)
+		{
+			LCD_DATA_WRITE(ucHigh); LCD_WR_STROBE_HOLD LCD_DATA_WRITE(ucLow); LCD_WR_STROBE_HOLD
+			LCD_DATA_WRITE(ucHigh); LCD_WR_STROBE_HOLD LCD_DATA_WRITE(ucLow); LCD_WR_STROBE_HOLD
+			ulCount -= 2;
+		}
+		if(ulCount)
+		{
+			LCD_DATA_WRITE(ucHigh); LCD_WR_STROBE_HOLD LCD_DATA_WRITE(ucLow); LCD_WR_STROBE_HOLD
+		}
+	}
+	else
+	{
+		// Alternate between the 2 bytes of the color
+		while(ulCount >= 4)
+		{
+			LCD_DATA_WRITE(ucHigh); LCD_WR_STROBE LCD_DATA_WRITE(ucLow); LCD_WR_STROBE
+			LCD_DATA_WRITE(ucHigh); LCD_WR_STROBE LCD_DATA_WRITE(ucLow); LCD_WR_STROBE
+			LCD_DATA_WRITE(ucHigh); LCD_WR_STROBE LCD_DATA_WRITE(ucLow); LCD_WR_STROBE
+			LCD_DATA_WRITE(ucHigh); LCD_WR_STROBE LCD_DATA_WRITE(ucLow); LCD_WR_STROBE
+			ulCount -= 4;
+		}
+		while(ulCount)
+		{
+			LCD_DATA_WRITE(ucHigh); LCD_WR_STROBE LCD_DATA_WRITE(ucLow); LCD_WR_STROBE
+			ulCount--;
+		}
+	}
 #endif
-
-	// Set pointer to first address in that window
-	LCDGoto(pRect->sXMin, pRect->sYMin);
 }
 
-// Initializing display
-void Adafruit320x240x16_ILI9325Init(void)
+// Write ulCount words from pusData within a burst
+// Two pixels are read with each aligned word access and split into their bus bytes
+void LCDBurstWrite(const unsigned short *pusData, unsigned long ulCount)
 {
-	unsigned short usAddress, usData;
-
-	// Reset global variables
-	g_ulWait1ms = SysCtlClockGet() / (3 * 1000);
-
-	// Enable GPIO peripherals
-	SysCtlPeripheralEnable(LCD_DATA_PERIPH);
-    SysCtlPeripheralEnable(LCD_CS_PERIPH);
-	SysCtlPeripheralEnable(LCD_CD_PERIPH);
-    SysCtlPeripheralEnable(LCD_WR_PERIPH);
-    SysCtlPeripheralEnable(LCD_RD_PERIPH);
-    SysCtlPeripheralEnable(LCD_RST_PERIPH);
-    SysCtlPeripheralEnable(LCD_BKLT_PERIPH);
+	const unsigned long *pulData;
+	unsigned long ulPair;
 
-    // Configure pins, all output
-    GPIOPinTypeGPIOOutput(LCD_DATA_BASE, LCD_DATA_PINS);
-    GPIOPinTypeGPIOOutput(LCD_CS_BASE, LCD_CS_PIN);
-    GPIOPinTypeGPIOOutput(LCD_CD_BASE, LCD_CD_PIN);
-    GPIOPinTypeGPIOOutput(LCD_WR_BASE, LCD_WR_PIN);
-    GPIOPinTypeGPIOOutput(LCD_RD_BASE, LCD_RD_PIN);
-    GPIOPinTypeGPIOOutput(LCD_BKLT_BASE, LCD_BKLT_PIN);
-    GPIOPinTypeGPIOOutput(LCD_RST_BASE, LCD_RST_PIN);
+	if((unsigned long)pusData & 1)
+	{
+		// Odd address, e.g. pixel data in a byte stream, read byte by byte
+		const unsigned char *pucData = (const unsigned char *)pusData;
+		while(ulCount)
+		{
+			LCD_BURST_BYTES(pucData[1], pucData[0]);
+			pucData += 2;
+			ulCount--;
+		}
+		return;
+	}
 
-    // Set control pins to idle/off state
-    LCD_CS_IDLE
-    LCD_RD_IDLE
-    LCD_WR_IDLE
-    LCD_BKLT_OFF
+	if(((unsigned long)pusData & 2) && ulCount)
+	{
+		// Single pixel up to next word boundary
+		LCD_BURST_WRITE(*pusData);
+		pusData++;
+		ulCount--;
+	}
 
-	// Reset LCD
-    LCD_RST_ACTIVE
-	LCD_DELAY(50);
-	LCD_RST_IDLE
-	LCD_DELAY(50);
+	// Whole words, first pixel is in the lower half
+	pulData = (const unsigned long *)pusData;
+	if(g_bWrHold)
+	{
+		while(ulCount >= 2)
+		{
+			ulPair = *pulData++;
+			LCD_BURST_BYTES_HOLD(ulPair >> 8, ulPair);
+			LCD_BURST_BYTES_HOLD(ulPair >> 24, ulPair >> 16);
+			ulCount -= 2;
+		}
+	}
+	else
+	{
+		while(ulCount >= 4)
+		{
+			ulPair = *pulData++;
+			LCD_BURST_BYTES_FAST(ulPair >> 8, ulPair);
+			LCD_BURST_BYTES_FAST(ulPair >> 24, ulPair >> 16);
+			ulPair = *pulData++;
+			LCD_BURST_BYTES_FAST(ulPair >> 8, ulPair);
+			LCD_BURST_BYTES_FAST(ulPair >> 24, ulPair >> 16);
+			ulCount -= 4;
+		}
+		if(ulCount >= 2)
+		{
+			ulPair = *pulData++;
+			LCD_BURST_BYTES_FAST(ulPair >> 8, ulPair);
+			LCD_BURST_BYTES_FAST(ulPair >> 24, ulPair >> 16);
+			ulCount -= 2;
+		}
+	}
 
-	// Talk to LCD for init
-	LCD_CS_ACTIVE
+	if(ulCount)
+	{
+		// Single pixel after last whole word
+		LCD_BURST_WRITE(*(const unsigned short *)pulData);
+	}
+}
 
-	// Sync communication
-	LCDWriteData(0);
-	LCDWriteData(0);
-	LCDWriteData(0);
-	LCDWriteData(0);
-	LCD_DELAY(50);
+// Write ulBytes bytes from pucData to the bus within a burst, e.g. pixels stored in bus order
+// Bytes up to the first word boundary are written singly, then four are read per word access
+void LCDBurstBytes(const unsigned char *pucData, unsigned long ulBytes)
+{
+#ifdef LCD_BUS_16BIT
+	// Both bytes of a pixel are written with one strobe, ulBytes must be even
+	while(ulBytes >= 2)
+	{
+		LCD_BURST_BYTES(pucData[0], pucData[1]);
+		pucData += 2;
+		ulBytes -= 2;
+	}
+#else
+	const unsigned long *pulData;
+	unsigned long ulQuad;
 
-	// Process initialization sequence of display driver
-	int i = 0;
-	while(usInitScript[i] != ILI_STOPCMD)
+	while(((unsigned long)pucData & 3) && ulBytes)
 	{
-		usAddress = usInitScript[i++];
-		usData = usInitScript[i++];
+		LCD_DATA_WRITE(*pucData++);
+		if(g_bWrHold) LCD_WR_STROBE_HOLD else LCD_WR_STROBE
+		ulBytes--;
+	}
 
-		if(usAddress == ILI_DELAYCMD)
+	// Whole words, first byte is in the lowest bits
+	pulData = (const unsigned long *)pucData;
+	if(g_bWrHold)
+	{
+		while(ulBytes >= 4)
 		{
-			LCD_DELAY(usData);
+			ulQuad = *pulData++;
+			LCD_BURST_BYTES_HOLD(ulQuad, ulQuad >> 8);
+			LCD_BURST_BYTES_HOLD(ulQuad >> 16, ulQuad >> 24);
+			ulBytes -= 4;
 		}
-		else
+	}
+	else
+	{
+		while(ulBytes >= 8)
 		{
-			LCDWriteCommand(usAddress);
-			LCDWriteData(usData);
+			ulQuad = *pulData++;
+			LCD_BURST_BYTES_FAST(ulQuad, ulQuad >> 8);
+			LCD_BURST_BYTES_FAST(ulQuad >> 16, ulQuad >> 24);
+			ulQuad = *pulData++;
+			LCD_BURST_BYTES_FAST(ulQuad, ulQuad >> 8);
+			LCD_BURST_BYTES_FAST(ulQuad >> 16, ulQuad >> 24);
+			ulBytes -= 8;
 		}
 	}
 
-	// Clear display of any stray pixels
-	LCDClear();
-
-	// Done talking to LCD
-	LCD_CS_IDLE
-
-	// Turn back light on
-	LCD_BKLT_ON
-
-	return;
+	pucData = (const unsigned char *)pulData;
+	while(ulBytes)
+	{
+		LCD_DATA_WRITE(*pucData++);
+		if(g_bWrHold) LCD_WR_STROBE_HOLD else LCD_WR_STROBE
+		ulBytes--;
+	}
+#endif
 }
 
-void Adafruit320x240x16_ILI9325PixelDraw(void *pvDisplayData, long lX, long lY, unsigned long ulValue)
+// End a burst of ulCount data words written to GRAM
+void LCDBurstEnd(unsigned long ulCount)
 {
-	// Start talking to LCD
-	LCD_CS_ACTIVE
-
-	LCDGoto(lX, lY);
-	LCDWriteData(ulValue);
-
-	// Done talking to LCD
-	LCD_CS_IDLE
+	// C/D is switched back by the next LCDWriteCommand, but the GRAM address
+	// counter has moved and the shadow copy must follow
+	LCDCursorAdvance(ulCount);
 }
 
-void Adafruit320x240x16_ILI9325PixelDrawMultiple(void *pvDisplayData,
-												 long lX, long lY, long lX0, long lCount, long lBPP,
-												 const unsigned char *pucData,
-												 const unsigned char *pucPalette)
+// Switch data port to input, C/D must select data
+void LCDReadBegin(void)
 {
-	// Start talking to LCD
-	LCD_CS_ACTIVE
-
-#ifdef LANDSCAPE
-	// Configure write direction to horizontal
-	LCDWriteCommand(ILI_ENTRY_MOD);
-	LCDWriteData(0x1038);
+	LCD_CD_DATA
+	GPIOPinTypeGPIOInput(LCD_DATA_BASE, LCD_DATA_PINS);
+#ifdef LCD_BUS_16BIT
+	GPIOPinTypeGPIOInput(LCD_DATA_HIGH_BASE, LCD_DATA_HIGH_PINS);
 #endif
+}
 
-	LCDGoto(lX,lY);
-
-	unsigned long ulPixel = 0;
-	unsigned long ulColor = 0;
-
-    if(lBPP == 1)
-    {
-    	// 1 bit per pixel in pucData
-    	// lX0 is the index of the bit processed within a byte
-    	// pucPalette holds the pre-translated 32bit display color
-    	while(lCount)
-    	{
-    		ulPixel = *pucData++;
-
-    		while(lCount && lX0 < 8)	// while there are pixels in this byte
-    		{
-    			ulColor = ((unsigned long *)pucPalette)[ulPixel & 1];	// retrieve already translated color
-    			LCDWriteData(ulColor);
-
-    			lCount--;		// processed another pixel
-    			lX0++;			// done with this bit
-    			ulPixel >>= 1;	// prepare next bit
-    		}
-
-    		lX0 = 0;	// process next byte, reset bit counter
-    	}
-    }
-    else if(lBPP == 4)
-    {
-    	// 4 bits per pixel in pucData
-    	// lX0 holds 0/1 to indicate 4-bit nibble within byte
-    	// pucPalette holds untranslated 24 bit color
-    	while(lCount)
-    	{
-    		if(lX0 == 0)	// read first nibble
-    		{
-    			ulPixel = *pucData >> 4;
-    			lX0 = 1;	// set index to second nibble
-    		}
-    		else
-    		{				// read second nibble
-    			ulPixel = *pucData & 0x0f;
-    			pucData++;	// increase byte pointer as we're done reading this byte
-    			lX0 = 0;	// set index to first nibble
-    		}
-
-			ulColor = *(unsigned long *)(pucPalette + (ulPixel*3)) & 0x00ffffff;	// retrieve 24 bit color
-			LCDWriteData(COLOR24TO16BIT(ulColor));					// translate and write to display
+// Read a word, high byte first, with one RD strobe per byte, or one strobe on a 16-bit bus
+unsigned short LCDReadWord(void)
+{
+	unsigned short usData;
+
+#ifdef LCD_BUS_16BIT
+	LCD_RD_ACTIVE
+	LCD_READ_DELAY
+	usData = ((LCD_DATA_HIGH_READ & 0xff) << 8) | (LCD_DATA_READ & 0xff);
+	LCD_RD_IDLE
+	LCD_READ_DELAY
+#else
+	LCD_RD_ACTIVE
+	LCD_READ_DELAY
+	usData = LCD_DATA_READ << 8;
+	LCD_RD_IDLE
+	LCD_READ_DELAY
+
+	LCD_RD_ACTIVE
+	LCD_READ_DELAY
+	usData |= LCD_DATA_READ & 0xff;
+	LCD_RD_IDLE
+	LCD_READ_DELAY
+#endif
 
-			lCount--;	// processed another pixel
-    	}
-    }
-    else if(lBPP == 8)
-    {
-    	// 8 bits per pixel in pucData
-    	// pucPalette holds untranslated 24 bit color
-    	while(lCount)
-    	{
-   			ulPixel = *pucData++;		// read pixel
-			ulColor = *(unsigned long *)(pucPalette + (ulPixel*3)) & 0x00ffffff;	// retrieve 24 bit color
-			LCDWriteData(COLOR24TO16BIT(ulColor));		// translate color and write to display
-			lCount--;	// processed another pixel
-    	}
-    }
-    else if(lBPP == 16)
-    {
-    	// 16 bits per pixel
-    	// Pixel is in 16bit color, 5R 6G 5B format
-        // No color translation needed for this display
-        while(lCount)
-        {
-        	ulPixel = *((unsigned short *)pucData);
-            LCDWriteData(ulPixel);
-            pucData += 2;
-            lCount--;
-        }
-    }
+	return usData;
+}
 
-#ifdef LANDSCAPE
-	// Reset write direction to default (vertical)
-	LCDWriteCommand(ILI_ENTRY_MOD);
-	LCDWriteData(0x1030);
+// Switch data port back to output
+// The controller may have moved its address counter ahead while reading, so the next
+// access to GRAM must set the address again
+void LCDReadEnd(void)
+{
+	GPIOPinTypeGPIOOutput(LCD_DATA_BASE, LCD_DATA_PINS);
+#ifdef LCD_BUS_16BIT
+	GPIOPinTypeGPIOOutput(LCD_DATA_HIGH_BASE, LCD_DATA_HIGH_PINS);
 #endif
 
-	// Done talking to LCD
-	LCD_CS_IDLE
+	g_pusShadow[LCD_SHADOW_GRAM_HOR_AD] = LCD_SHADOW_INVALID;
+	g_pusShadow[LCD_SHADOW_GRAM_VER_AD] = LCD_SHADOW_INVALID;
 }
 
-void Adafruit320x240x16_ILI9325LineDrawH(void *pvDisplayData,
-										 long lX1, long lX2, long lY, unsigned long ulValue)
+// Set GRAM address of next display write
+// Nothing is sent if the address counter is already there after the previous write
+void LCDGoto(unsigned short usH, unsigned short usV)
 {
-	// Start talking to LCD
-	LCD_CS_ACTIVE
+	if(usH >= LCD_X) usH = LCD_X - 1;
+	if(usV >= LCD_Y) usV = LCD_Y - 1;
 
-#ifdef LANDSCAPE
-	// 	Configure write direction to horizontal
-	LCDWriteCommand(ILI_ENTRY_MOD);
-	LCDWriteData(0x1038);
-#endif
+	LCDWriteRegister(ILI_GRAM_HOR_AD, usH);		// GRAM Address Set (Horizontal Address) (R20h)
+	LCDWriteRegister(ILI_GRAM_VER_AD, usV);		// GRAM Address Set (Vertical Address) (R21h)
 
-	long x = lX1;
-	LCDGoto(x, lY);
-	while(x <= lX2)
+	if(g_ucIndex != ILI_RW_GRAM)
 	{
-		LCDWriteData(ulValue);
-		x++;
+		LCDWriteCommand(ILI_RW_GRAM);			// Write Data to GRAM (R22h)
 	}
+}
 
-#ifdef LANDSCAPE
-	// Reset write direction to default (vertical)
-	LCDWriteCommand(ILI_ENTRY_MOD);
-	LCDWriteData(0x1030);
-#endif
+// Configure display controller to write to defined area, pRect in GRAM coordinates
+void LCDWindowSet(const tRectangle *pRect)
+{
+	LCDWriteRegister(ILI_HOR_START_AD, pRect->sXMin);
+	LCDWriteRegister(ILI_HOR_END_AD, pRect->sXMax);
+	LCDWriteRegister(ILI_VER_START_AD, pRect->sYMin);
+	LCDWriteRegister(ILI_VER_END_AD, pRect->sYMax);
 
-	// Done talking to LCD
-	LCD_CS_IDLE
+	g_sWindow = *pRect;
 }
 
-void Adafruit320x240x16_ILI9325LineDrawV(void *pvDisplayData,
-										 long lX, long lY1, long lY2, unsigned long ulValue)
+// Make sure the active window contains the given area, otherwise switch to full screen
+// Primitives call this instead of restoring the full screen window after themselves
+void LCDWindowCover(long lH1, long lV1, long lH2, long lV2)
 {
-	// Start talking to LCD
-	LCD_CS_ACTIVE
+	if((lH1 < g_sWindow.sXMin) || (lH2 > g_sWindow.sXMax) ||
+	   (lV1 < g_sWindow.sYMin) || (lV2 > g_sWindow.sYMax))
+	{
+		LCDWindowSet(&g_FullScreen);
+	}
+}
 
-#ifdef PORTRAIT
-	// Configure write direction to horizontal
-	LCDWriteCommand(ILI_ENTRY_MOD);
-	LCDWriteData(0x1018);
-#endif
+// Configure display controller to write to defined area, starting at its first address
+void LCDAddressWindow(const tRectangle *pRect)
+{
+	LCDWindowSet(pRect);
 
-	long y = lY1;
+	// Set pointer to first address in that window
+	LCDGoto(pRect->sXMin, pRect->sYMin);
+}
 
-	LCDGoto(lX, lY2);
+// Start talking to LCD, unless a batched session is already open
+void LCDSessionBegin(void)
+{
+	if(!g_bSessionOpen)
+	{
+		LCD_CS_ACTIVE
+		g_bSessionOpen = g_bBatch;
+	}
+}
 
-	while(y <= lY2)
+// Close a batched session, the next primitive asserts CS again
+void LCDSessionClose(void)
+{
+	if(g_bSessionOpen)
 	{
-		LCDWriteData(ulValue);
-		y++;
+		LCD_CS_IDLE
+		g_bSessionOpen = false;
 	}
+	g_ulBatchOps = 0;
+}
 
-#ifdef PORTRAIT
-	// Reset write direction to default (vertical)
-	LCDWriteCommand(ILI_ENTRY_MOD);
-	LCDWriteData(0x1030);
-#endif
+// Done talking to LCD, in batched mode CS stays asserted until the session is closed
+void LCDSessionEnd(void)
+{
+	if(!g_bSessionOpen)
+	{
+		LCD_CS_IDLE
+	}
+	else if(g_ulBatchMaxOps && (++g_ulBatchOps >= g_ulBatchMaxOps))
+	{
+		LCDSessionClose();
+	}
+}
 
-	// Done talking to LCD
-	LCD_CS_IDLE
+// Enable batched mode, CS stays asserted across primitives until GrFlush,
+// Adafruit320x240x16_ILI9325BatchEnd or ulMaxOps primitives (0 for no limit)
+// No other code may use the pins of the LCD bus while a batch is open
+void Adafruit320x240x16_ILI9325BatchBegin(unsigned long ulMaxOps)
+{
+	g_ulBatchMaxOps = ulMaxOps;
+	g_ulBatchOps = 0;
+	g_bBatch = true;
 }
 
-void Adafruit320x240x16_ILI9325RectFill(void *pvDisplayData,
-										const tRectangle *pRect, unsigned long ulValue)
+// Close open session and return to one session per primitive
+void Adafruit320x240x16_ILI9325BatchEnd(void)
 {
-	// Start talking to LCD
-	LCD_CS_ACTIVE
+	g_bBatch = false;
+	LCDSessionClose();
+}
 
-	LCDAddressWindow(pRect);
+// Clear ulLines lines of GRAM starting at vertical address ulLine
+void LCDClear(unsigned long ulLine, unsigned long ulLines)
+{
+	LCDWindowSet(&g_FullScreen);
+	LCDGoto(0, ulLine);
 
-	int i = 0;
-	int pixel = (pRect->sXMax - pRect->sXMin + 1) * (pRect->sYMax - pRect->sYMin + 1);	// bug fix by jks-liu on github
+	// Write black pixels
+	LCDBurstBegin();
+	LCDBurstRepeat(0, LCD_X * ulLines);
+	LCDBurstEnd(LCD_X * ulLines);
+}
 
-	while(i < pixel)
+// Configure scan direction of the active orientation
+// Portrait orientations map display X/Y to horizontal/vertical GRAM address,
+// landscape orientations swap them. Mirroring is done by the controller, so
+// no coordinate needs to be subtracted and all entry modes increment.
+void LCDScanSet(void)
+{
+	unsigned short usDrivOut = 0;
+	unsigned short usGateScan = ILI_GATE_SCAN_CTRL1_320;
+
+	switch(g_ulRotation)
 	{
-		LCDWriteData(ulValue);	// Write pixel
-		i++;
+	case ADAFRUIT_ILI9325_PORTRAIT:
+		usDrivOut |= ILI_DRIV_OUT_CTRL_SS;
+		usGateScan |= ILI_GATE_SCAN_CTRL1_GS;
+		break;
+	case ADAFRUIT_ILI9325_LANDSCAPE:
+		usGateScan |= ILI_GATE_SCAN_CTRL1_GS;
+		break;
+	case ADAFRUIT_ILI9325_LANDSCAPE_FLIP:
+		usDrivOut |= ILI_DRIV_OUT_CTRL_SS;
+		break;
+	default:
+		break;
 	}
 
-	LCDAddressWindow(&g_FullScreen);
+	LCDWriteRegister(ILI_DRIV_OUT_CTRL, usDrivOut);
+	LCDWriteRegister(ILI_GATE_SCAN_CTRL1, usGateScan);
 
-	// Done talking to LCD
-	LCD_CS_IDLE
+	// Forget image rows drawn in the previous orientation
+	g_lRowCount = 0;
 }
 
-static unsigned long Adafruit320x240x16_ILI9325ColorTranslate(void *pvDisplayData, unsigned long ulValue)
+// Start initializing display, returns without waiting for the controller
+// Initialization continues in Adafruit320x240x16_ILI9325InitTick, pfnDone (or 0)
+// is called from there once the display is ready. Nothing may be drawn before.
+void Adafruit320x240x16_ILI9325InitStart(tILI9325InitCallback pfnDone)
+{
+	// Reset global variables
+	g_ulWait1ms = SysCtlClockGet() / (3 * 1000);
+	g_ulReadDelay = SysCtlClockGet() / (3 * 4000000) + 1;
+	g_bWrHold = (SysCtlClockGet() > LCD_WR_HOLD_CLOCK);
+	g_bBatch = false;
+	g_bSessionOpen = false;
+	g_pfnInitDone = pfnDone;
+	Adafruit320x240x16_ILI9325CacheInvalidate();
+
+	// Enable GPIO peripherals
+	SysCtlPeripheralEnable(LCD_DATA_PERIPH);
+#ifdef LCD_BUS_16BIT
+	SysCtlPeripheralEnable(LCD_DATA_HIGH_PERIPH);
+#endif
+    SysCtlPeripheralEnable(LCD_CS_PERIPH);
+	SysCtlPeripheralEnable(LCD_CD_PERIPH);
+    SysCtlPeripheralEnable(LCD_WR_PERIPH);
+    SysCtlPeripheralEnable(LCD_RD_PERIPH);
+    SysCtlPeripheralEnable(LCD_RST_PERIPH);
+    SysCtlPeripheralEnable(LCD_BKLT_PERIPH);
+
+    // Configure pins, all output
+    GPIOPinTypeGPIOOutput(LCD_DATA_BASE, LCD_DATA_PINS);
+#ifdef LCD_BUS_16BIT
+    GPIOPinTypeGPIOOutput(LCD_DATA_HIGH_BASE, LCD_DATA_HIGH_PINS);
+#endif
+    GPIOPinTypeGPIOOutput(LCD_CS_BASE, LCD_CS_PIN);
+    GPIOPinTypeGPIOOutput(LCD_CD_BASE, LCD_CD_PIN);
+    GPIOPinTypeGPIOOutput(LCD_WR_BASE, LCD_WR_PIN);
+    GPIOPinTypeGPIOOutput(LCD_RD_BASE, LCD_RD_PIN);
+    GPIOPinTypeGPIOOutput(LCD_BKLT_BASE, LCD_BKLT_PIN);
+    GPIOPinTypeGPIOOutput(LCD_RST_BASE, LCD_RST_PIN);
+
+    // Set control pins to idle/off state
+    LCD_CTRL_IDLE
+    LCD_BKLT_OFF
+
+	// Reset LCD, released by the first step
+    LCD_RST_ACTIVE
+	g_ulInitState = LCD_INIT_RESET;
+	g_ulInitWait = 50;
+}
+
+// Continue initializing display, ulMs is the time in milliseconds since the previous call
+// Call from a timer interrupt or poll from the main loop, returns true once the display is ready.
+// A tick runs all steps up to the next delay of the init script, or clears LCD_INIT_CLEAR_LINES lines.
+tBoolean Adafruit320x240x16_ILI9325InitTick(unsigned long ulMs)
+{
+	unsigned short usAddress, usData;
+
+	if(g_ulInitState == LCD_INIT_DONE)
+	{
+		return true;
+	}
+
+	if(g_ulInitWait > ulMs)
+	{
+		g_ulInitWait -= ulMs;
+		return false;
+	}
+	g_ulInitWait = 0;
+
+	while(!g_ulInitWait)
+	{
+		switch(g_ulInitState)
+		{
+		case LCD_INIT_RESET:
+			LCD_RST_IDLE
+			g_ulInitState = LCD_INIT_SYNC;
+			g_ulInitWait = 50;
+			break;
+
+		case LCD_INIT_SYNC:
+			// Talk to LCD until init is done
+			LCD_CS_ACTIVE
+#ifndef LCD_BUS_16BIT
+			// Sync communication, realigns the transfer of upper and lower byte on the 8-bit bus
+			LCDWriteData(0);
+			LCDWriteData(0);
+			LCDWriteData(0);
+			LCDWriteData(0);
+			g_ulInitWait = 50;
+#endif
+			g_ulInitState = LCD_INIT_SCRIPT;
+			g_ulInitPos = 0;
+			break;
+
+		case LCD_INIT_SCRIPT:
+			// Process initialization sequence of display driver
+			usAddress = usInitScript[g_ulInitPos];
+			if(usAddress == ILI_STOPCMD)
+			{
+				// Set scan direction of default orientation, scrolling is reset by the script
+				g_ulRotation = LCD_ROTATION_DEFAULT;
+				g_ulScroll = 0;
+				LCDScanSet();
+
+				g_ulInitState = LCD_INIT_CLEAR;
+				g_ulInitPos = 0;
+				break;
+			}
+			usData = usInitScript[g_ulInitPos + 1];
+			g_ulInitPos += 2;
+
+			if(usAddress == ILI_DELAYCMD)
+			{
+				g_ulInitWait = usData;
+			}
+			else
+			{
+				LCDWriteRegister(usAddress, usData);
+			}
+
+			if(usAddress == ILI_DISP_CTRL1)
+			{
+				g_usDisplayControl = usData;
+			}
+			break;
+
+		case LCD_INIT_CLEAR:
+			// Clear display of any stray pixels, one band per tick
+			LCDClear(g_ulInitPos, LCD_INIT_CLEAR_LINES);
+			g_ulInitPos += LCD_INIT_CLEAR_LINES;
+			if(g_ulInitPos < LCD_Y)
+			{
+				return false;
+			}
+
+			// Done talking to LCD
+			LCD_CS_IDLE
+
+			// Turn back light on
+			LCD_BKLT_ON
+
+			g_ulInitState = LCD_INIT_DONE;
+			if(g_pfnInitDone)
+			{
+				g_pfnInitDone();
+			}
+			return true;
+
+		default:
+			// Not started
+			return false;
+		}
+	}
+
+	return false;
+}
+
+// True once the display is initialized
+tBoolean Adafruit320x240x16_ILI9325InitDone(void)
+{
+	return (g_ulInitState == LCD_INIT_DONE);
+}
+
+// Initializing display, waits until done
+void Adafruit320x240x16_ILI9325Init(void)
+{
+	Adafruit320x240x16_ILI9325InitStart(0);
+
+	do
+	{
+		if(g_ulInitWait)
+		{
+			LCD_DELAY(g_ulInitWait);
+		}
+	}
+	while(!Adafruit320x240x16_ILI9325InitTick(g_ulInitWait));
+
+	return;
+}
+
+// Return palette translated to display colors, from cache or translated into the oldest slot
+// Only ulEntries entries are read, the other slots of the table are unused. PixelDrawMultiple is not
+// told the size of a palette and passes 16 or 256 for the color depth, ImageDraw the size of the image.
+static const tLCDPalette *LCDPaletteGet(const unsigned char *pucPalette, unsigned long ulEntries)
+{
+	tLCDPalette *psSlot;
+	unsigned long ulColor, i;
+
+	for(i = 0; i < LCD_PALETTE_CACHE_SLOTS; i++)
+	{
+		psSlot = &g_psPaletteCache[i];
+		if((psSlot->pucPalette == pucPalette) && (psSlot->ulEntries >= ulEntries))
+		{
+			return psSlot;
+		}
+	}
+
+	psSlot = &g_psPaletteCache[g_ulPaletteNext];
+	g_ulPaletteNext = (g_ulPaletteNext + 1) % LCD_PALETTE_CACHE_SLOTS;
+
+	for(i = 0; i < ulEntries; i++)
+	{
+		ulColor = pucPalette[i*3] | (pucPalette[i*3+1] << 8) | (pucPalette[i*3+2] << 16);	// retrieve 24 bit color
+		ulColor = COLOR24TO16BIT(ulColor);					// translate to display color
+		psSlot->pucHigh[i] = ulColor >> 8;
+		psSlot->pucLow[i] = ulColor & 0xff;
+	}
+	psSlot->pucPalette = pucPalette;
+	psSlot->ulEntries = ulEntries;
+
+	return psSlot;
+}
+
+// Drop cached translation of a palette in RAM after it was changed, or of all palettes if pucPalette is 0
+void Adafruit320x240x16_ILI9325PaletteInvalidate(const unsigned char *pucPalette)
+{
+	unsigned long i;
+
+	for(i = 0; i < LCD_PALETTE_CACHE_SLOTS; i++)
+	{
+		if((pucPalette == 0) || (g_psPaletteCache[i].pucPalette == pucPalette))
+		{
+			g_psPaletteCache[i].pucPalette = 0;
+		}
+	}
+}
+
+// Expand 1 bit per pixel data, e.g. glyphs of fonts, to background and foreground color
+// Bytes with all bits equal are collected to solid spans and written by the run fill engine.
+// Other bytes are written nibble by nibble from a table with the bus bytes of all 16 patterns,
+// which is rebuilt whenever the colors change.
+void LCDPixelStream1BPP(long lX0, long lCount, const unsigned char *pucData, const unsigned long *pulPalette)
+{
+	unsigned long ulByte, ulRun, ulBit, i;
+	const unsigned char *pucBytes;
+
+	if((pulPalette[0] != g_ulNibbleBackground) || (pulPalette[1] != g_ulNibbleForeground))
+	{
+		g_ulNibbleBackground = pulPalette[0];
+		g_ulNibbleForeground = pulPalette[1];
+
+		for(i = 0; i < 16 * 4; i++)
+		{
+			ulBit = (i >> 2) & (8 >> (i & 3));		// bit of pixel i & 3 in nibble i >> 2
+			g_pucNibble[i >> 2][(i & 3) * 2] = pulPalette[ulBit ? 1 : 0] >> 8;
+			g_pucNibble[i >> 2][(i & 3) * 2 + 1] = pulPalette[ulBit ? 1 : 0] & 0xff;
+		}
+	}
+
+	// Pixels before the first whole byte
+	if(lX0)
+	{
+		ulByte = *pucData++;
+		while(lCount && lX0 < 8)
+		{
+			ulBit = (ulByte >> (7 - lX0)) & 1;
+			LCD_BURST_BYTES(pulPalette[ulBit] >> 8, pulPalette[ulBit] & 0xff);
+			lCount--;
+			lX0++;
+		}
+	}
+
+	// Whole bytes
+	while(lCount >= 8)
+	{
+		ulByte = *pucData;
+
+		if((ulByte == 0x00) || (ulByte == 0xff))
+		{
+			// Solid span of one color, extend over all following bytes with the same value
+			ulRun = 0;
+			while((lCount >= 8) && (*pucData == ulByte))
+			{
+				ulRun += 8;
+				lCount -= 8;
+				pucData++;
+			}
+			LCDBurstRepeat(pulPalette[ulByte & 1], ulRun);
+		}
+		else
+		{
+			pucBytes = g_pucNibble[ulByte >> 4];
+			LCD_BURST_BYTES(pucBytes[0], pucBytes[1]);
+			LCD_BURST_BYTES(pucBytes[2], pucBytes[3]);
+			LCD_BURST_BYTES(pucBytes[4], pucBytes[5]);
+			LCD_BURST_BYTES(pucBytes[6], pucBytes[7]);
+			pucBytes = g_pucNibble[ulByte & 0x0f];
+			LCD_BURST_BYTES(pucBytes[0], pucBytes[1]);
+			LCD_BURST_BYTES(pucBytes[2], pucBytes[3]);
+			LCD_BURST_BYTES(pucBytes[4], pucBytes[5]);
+			LCD_BURST_BYTES(pucBytes[6], pucBytes[7]);
+			lCount -= 8;
+			pucData++;
+		}
+	}
+
+	// Pixels after the last whole byte
+	if(lCount)
+	{
+		ulByte = *pucData;
+		for(lX0 = 0; lX0 < lCount; lX0++)
+		{
+			ulBit = (ulByte >> (7 - lX0)) & 1;
+			LCD_BURST_BYTES(pulPalette[ulBit] >> 8, pulPalette[ulBit] & 0xff);
+		}
+	}
+}
+
+// Orientation independent part of PixelDrawMultiple, streams lCount pixels to GRAM
+void LCDPixelStream(long lX0, long lCount, long lBPP,
+					const unsigned char *pucData, const unsigned char *pucPalette)
+{
+	unsigned long ulPixel = 0;
+
+    if(lBPP == 1)
+    {
+    	// 1 bit per pixel in pucData
+    	// lX0 is the index of the bit processed within a byte, most significant bit first
+    	// pucPalette holds the pre-translated 32bit display color
+    	LCDPixelStream1BPP(lX0, lCount, pucData, (const unsigned long *)pucPalette);
+    }
+    else if(lBPP == 4)
+    {
+    	// 4 bits per pixel in pucData
+    	// lX0 holds 0/1 to indicate 4-bit nibble within byte
+    	// pucPalette holds untranslated 24 bit color, translated through palette cache
+    	const tLCDPalette *psPalette = LCDPaletteGet(pucPalette, 16);
+    	const unsigned char *pucHigh = psPalette->pucHigh;
+    	const unsigned char *pucLow = psPalette->pucLow;
+
+    	if(lX0 && lCount)	// start with second nibble
+    	{
+    		ulPixel = *pucData++ & 0x0f;
+    		LCD_BURST_BYTES(pucHigh[ulPixel], pucLow[ulPixel]);
+    		lCount--;
+    	}
+
+    	while(lCount >= 2)	// both nibbles of a byte
+    	{
+    		ulPixel = *pucData++;
+    		LCD_BURST_BYTES(pucHigh[ulPixel >> 4], pucLow[ulPixel >> 4]);
+    		ulPixel &= 0x0f;
+    		LCD_BURST_BYTES(pucHigh[ulPixel], pucLow[ulPixel]);
+    		lCount -= 2;
+    	}
+
+    	if(lCount)			// end with first nibble
+    	{
+    		ulPixel = *pucData >> 4;
+    		LCD_BURST_BYTES(pucHigh[ulPixel], pucLow[ulPixel]);
+    	}
+    }
+    else if(lBPP == 8)
+    {
+    	// 8 bits per pixel in pucData
+    	// pucPalette holds untranslated 24 bit color, translated through palette cache
+    	const tLCDPalette *psPalette = LCDPaletteGet(pucPalette, 256);
+    	const unsigned char *pucHigh = psPalette->pucHigh;
+    	const unsigned char *pucLow = psPalette->pucLow;
+
+    	while(lCount)
+    	{
+   			ulPixel = *pucData++;		// read pixel
+    		LCD_BURST_BYTES(pucHigh[ulPixel], pucLow[ulPixel]);
+			lCount--;	// processed another pixel
+    	}
+    }
+    else if(lBPP == 16)
+    {
+    	// 16 bits per pixel
+    	// Pixel is in 16bit color, 5R 6G 5B format
+        // No color translation needed for this display, same bulk path as Adafruit320x240x16_ILI9325Blit
+        LCDBurstWrite((const unsigned short *)pucData, lCount);
+    }
+}
+
+// Sprites drawn over the display content, with the pixels underneath saved for restoring
+// RAM used is LCD_SPRITE_COUNT * (LCD_SPRITE_PIXELS * 2 + 20) bytes
+#define LCD_SPRITE_COUNT		2
+#define LCD_SPRITE_PIXELS		576		// largest visible area, e.g. 24x24
+typedef struct
+{
+	const tILI9325Sprite *psImage;		// image of sprite
+	long lX;							// position of top left corner of image
+	long lY;
+	tRectangle sUnder;					// visible area in display coordinates
+	unsigned short pusUnder[LCD_SPRITE_PIXELS];		// pixels under visible area
+} tLCDSprite;
+static tLCDSprite g_psSprites[LCD_SPRITE_COUNT];
+static unsigned long g_ulSpritesVisible;		// bit per visible sprite
+
+// Draw opaque pixels of sprite within pArea, both in display coordinates, one burst per run of opaque pixels
+static void LCDSpriteDraw(const tLCDSprite *psSprite, const tRectangle *pArea)
+{
+	const tILI9325Sprite *psImage = psSprite->psImage;
+	unsigned long ulMaskStride = (psImage->usWidth + 7) / 8;
+	long lRow, lCol, lStart;
+	tRectangle sRun;
+
+	for(sRun.sYMin = pArea->sYMin; sRun.sYMin <= pArea->sYMax; sRun.sYMin++)
+	{
+		lRow = sRun.sYMin - psSprite->lY;
+		sRun.sYMax = sRun.sYMin;
+
+		for(lCol = pArea->sXMin - psSprite->lX; lCol <= pArea->sXMax - psSprite->lX; )
+		{
+			// Collect run of opaque pixels
+			for(lStart = lCol; lCol <= pArea->sXMax - psSprite->lX; lCol++)
+			{
+				if(psImage->pucMask ?
+				   !((psImage->pucMask[lRow * ulMaskStride + lCol / 8] >> (7 - (lCol & 7))) & 1) :
+				   (psImage->pusPixels[lRow * psImage->usWidth + lCol] == psImage->usKey))
+				{
+					break;
+				}
+			}
+
+			if(lCol > lStart)
+			{
+				sRun.sXMin = psSprite->lX + lStart;
+				sRun.sXMax = psSprite->lX + lCol - 1;
+				Adafruit320x240x16_ILI9325Blit(&sRun, psImage->pusPixels + lRow * psImage->usWidth + lStart, psImage->usWidth);
+			}
+			else
+			{
+				lCol++;		// skip transparent pixel
+			}
+		}
+	}
+}
+
+// Keep sprites on top of a primitive that drew into the area lX1/lY1 to lX2/lY2 in display coordinates
+// The new pixels under a sprite are read back as its background and the sprite is drawn over them again.
+static void LCDSpriteUpdate(long lX1, long lY1, long lX2, long lY2)
+{
+	tLCDSprite *psSprite;
+	tRectangle sArea;
+	long lStride;
+	unsigned long i;
+
+	for(i = 0; i < LCD_SPRITE_COUNT; i++)
+	{
+		psSprite = &g_psSprites[i];
+		if(!(g_ulSpritesVisible & (1 << i)))
+		{
+			continue;
+		}
+
+		sArea.sXMin = (lX1 > psSprite->sUnder.sXMin) ? lX1 : psSprite->sUnder.sXMin;
+		sArea.sYMin = (lY1 > psSprite->sUnder.sYMin) ? lY1 : psSprite->sUnder.sYMin;
+		sArea.sXMax = (lX2 < psSprite->sUnder.sXMax) ? lX2 : psSprite->sUnder.sXMax;
+		sArea.sYMax = (lY2 < psSprite->sUnder.sYMax) ? lY2 : psSprite->sUnder.sYMax;
+		if((sArea.sXMin > sArea.sXMax) || (sArea.sYMin > sArea.sYMax))
+		{
+			continue;
+		}
+
+		lStride = psSprite->sUnder.sXMax - psSprite->sUnder.sXMin + 1;
+		Adafruit320x240x16_ILI9325RectRead(&sArea, psSprite->pusUnder +
+										   (sArea.sYMin - psSprite->sUnder.sYMin) * lStride +
+										   (sArea.sXMin - psSprite->sUnder.sXMin), lStride);
+		LCDSpriteDraw(psSprite, &sArea);
+	}
+}
+
+// Queue of single pixels drawn by PixelDraw, e.g. by GrLineDraw and GrCircleDraw
+// Pixels are submitted on GrFlush, when another primitive or driver function draws, or when the queue
+// is full. Consecutive pixels each one step further in the same direction form a run, which is written
+// as one burst with a single GRAM address. RAM used is 6 bytes per pixel.
+#define LCD_PIXEL_QUEUE			64
+static short g_psPixelX[LCD_PIXEL_QUEUE];
+static short g_psPixelY[LCD_PIXEL_QUEUE];
+static unsigned short g_pusPixelColor[LCD_PIXEL_QUEUE];
+static unsigned long g_ulPixelQueued;
+
+// Write all queued pixels to the display in runs
+static void LCDPixelQueueSubmit(void)
+{
+	tBoolean bLandscape = (g_ulRotation & 1) ? true : false;
+	unsigned long ulQueued = g_ulPixelQueued;
+	unsigned long ulFirst, ulLast, ulCount, i;
+	long lDX = 0, lDY = 0, lX1, lY1, lX2, lY2;
+	tBoolean bHorizontal, bReverse;
+
+	// Sprites redrawn over the pixels submit the queue again, it must be empty then
+	g_ulPixelQueued = 0;
+
+	for(ulFirst = 0; ulFirst < ulQueued; ulFirst = ulLast + 1)
+	{
+		// Direction of run is given by its first two pixels
+		ulLast = ulFirst;
+		if(ulFirst + 1 < ulQueued)
+		{
+			lDX = g_psPixelX[ulFirst + 1] - g_psPixelX[ulFirst];
+			lDY = g_psPixelY[ulFirst + 1] - g_psPixelY[ulFirst];
+			if((lDX * lDX + lDY * lDY) == 1)
+			{
+				ulLast++;
+				while((ulLast + 1 < ulQueued) &&
+					  (g_psPixelX[ulLast + 1] - g_psPixelX[ulLast] == lDX) &&
+					  (g_psPixelY[ulLast + 1] - g_psPixelY[ulLast] == lDY))
+				{
+					ulLast++;
+				}
+			}
+		}
+		ulCount = ulLast - ulFirst + 1;
+
+		// Runs going left or up are written from their other end
+		bReverse = (ulCount > 1) && ((lDX < 0) || (lDY < 0));
+		lX1 = g_psPixelX[bReverse ? ulLast : ulFirst];
+		lY1 = g_psPixelY[bReverse ? ulLast : ulFirst];
+		lX2 = g_psPixelX[bReverse ? ulFirst : ulLast];
+		lY2 = g_psPixelY[bReverse ? ulFirst : ulLast];
+
+		// Start talking to LCD
+		LCDSessionBegin();
+
+		// Rows in display coordinates are horizontal in portrait and vertical in landscape GRAM
+		if(ulCount > 1)
+		{
+			bHorizontal = (lDY == 0) ? !bLandscape : bLandscape;
+			LCDWriteRegister(ILI_ENTRY_MOD, bHorizontal ? ILI_ENTRY_MOD_HOR : ILI_ENTRY_MOD_VER);
+		}
+		if(bLandscape)
+		{
+			LCDWindowCover(lY1, lX1, lY2, lX2);
+			LCDGoto(lY1, lX1);
+		}
+		else
+		{
+			LCDWindowCover(lX1, lY1, lX2, lY2);
+			LCDGoto(lX1, lY1);
+		}
+
+		LCDBurstBegin();
+		for(i = 0; i < ulCount; i++)
+		{
+			LCD_BURST_WRITE(g_pusPixelColor[bReverse ? ulLast - i : ulFirst + i]);
+		}
+		LCDBurstEnd(ulCount);
+
+		// Done talking to LCD
+		LCDSessionEnd();
+
+		// Draw sprites again over new pixels
+		if(g_ulSpritesVisible)
+		{
+			LCDSpriteUpdate(lX1, lY1, lX2, lY2);
+		}
+	}
+}
+
+// Queue a pixel in display coordinates, submitting the queue first if it is full
+static void LCDPixelQueueAdd(long lX, long lY, unsigned long ulValue)
+{
+	if(g_ulPixelQueued == LCD_PIXEL_QUEUE)
+	{
+		LCDPixelQueueSubmit();
+	}
+	g_psPixelX[g_ulPixelQueued] = lX;
+	g_psPixelY[g_ulPixelQueued] = lY;
+	g_pusPixelColor[g_ulPixelQueued] = ulValue;
+	g_ulPixelQueued++;
+}
+
+// Deferred rendering, primitives are recorded into a list and rendered on flush one tile at a time
+// into a RAM buffer, every tile is streamed to the display in one window so each pixel is written once.
+// Records are a tLCDRecord, followed by the RGB565 pixels of a multi pixel row, and padded to words.
+#define LCD_RECORD_FILL			0
+#define LCD_RECORD_PIXELS		1
+typedef struct
+{
+	unsigned short usType;				// LCD_RECORD_FILL or LCD_RECORD_PIXELS
+	unsigned short usColor;				// color of a fill
+	tRectangle sArea;					// area in display coordinates, one row for pixels
+} tLCDRecord;
+#define LCD_RECORD_WORDS(ulPixels)	((sizeof(tLCDRecord) + (ulPixels) * 2 + 3) / 4)
+
+tBoolean g_bDefer;
+unsigned long *g_pulTileMask;			// bit per pixel of tile, set once a record covers it
+unsigned short *g_pusTile;
+unsigned long g_ulTilePixels;
+unsigned long *g_pulList;
+unsigned long g_ulListWords;
+unsigned long g_ulListUsed;
+tRectangle g_sDeferArea;				// bounding box of recorded primitives
+
+// Translate lCount pixels of PixelDrawMultiple to RGB565, see LCDPixelStream for the formats of pucData
+static void LCDPixelExpand(long lX0, long lCount, long lBPP, const unsigned char *pucData,
+						   const unsigned char *pucPalette, unsigned short *pusPixels)
+{
+	const unsigned long *pulPalette = (const unsigned long *)pucPalette;
+	const tLCDPalette *psPalette;
+	unsigned long ulPixel;
+
+	if(lBPP == 1)
+	{
+		while(lCount--)
+		{
+			*pusPixels++ = pulPalette[(*pucData >> (7 - lX0)) & 1];
+			if(++lX0 == 8)
+			{
+				lX0 = 0;
+				pucData++;
+			}
+		}
+	}
+	else if((lBPP == 4) || (lBPP == 8))
+	{
+		psPalette = LCDPaletteGet(pucPalette, (lBPP == 4) ? 16 : 256);
+		while(lCount--)
+		{
+			if(lBPP == 8)
+			{
+				ulPixel = *pucData++;
+			}
+			else if(lX0)
+			{
+				ulPixel = *pucData++ & 0x0f;
+				lX0 = 0;
+			}
+			else
+			{
+				ulPixel = *pucData >> 4;
+				lX0 = 1;
+			}
+			*pusPixels++ = (psPalette->pucHigh[ulPixel] << 8) | psPalette->pucLow[ulPixel];
+		}
+	}
+	else if(lBPP == 16)
+	{
+		// Data may not be aligned to 16 bit
+		while(lCount--)
+		{
+			*pusPixels++ = pucData[0] | (pucData[1] << 8);
+			pucData += 2;
+		}
+	}
+}
+
+// Set ulCount bits of the tile mask starting with bit ulBit
+static void LCDTileCover(unsigned long ulBit, unsigned long ulCount)
+{
+	while(ulCount && (ulBit & 31))
+	{
+		g_pulTileMask[ulBit >> 5] |= 1UL << (ulBit & 31);
+		ulBit++;
+		ulCount--;
+	}
+	while(ulCount >= 32)
+	{
+		g_pulTileMask[ulBit >> 5] = 0xffffffff;
+		ulBit += 32;
+		ulCount -= 32;
+	}
+	while(ulCount)
+	{
+		g_pulTileMask[ulBit >> 5] |= 1UL << (ulBit & 31);
+		ulBit++;
+		ulCount--;
+	}
+}
+
+// Render the first ulWords words of the record list within pTile and stream the result to the display
+// The tile is written in one window if all its pixels are covered, otherwise one window per covered run of a row
+static void LCDDeferTile(const tRectangle *pTile, unsigned long ulWords)
+{
+	long lStride = pTile->sXMax - pTile->sXMin + 1;
+	unsigned long ulPixels = lStride * (pTile->sYMax - pTile->sYMin + 1);
+	const unsigned long *pulRecord = g_pulList;
+	const tLCDRecord *psRecord;
+	const unsigned short *pusPixels;
+	unsigned short *pusTile;
+	unsigned long ulBit, ulLength, i;
+	tRectangle sPart;
+	long lX, lY;
+
+	for(i = 0; i < (ulPixels + 31) / 32; i++)
+	{
+		g_pulTileMask[i] = 0;
+	}
+
+	// Draw records in order, later ones overwrite earlier ones
+	while(pulRecord < g_pulList + ulWords)
+	{
+		psRecord = (const tLCDRecord *)pulRecord;
+		ulLength = psRecord->sArea.sXMax - psRecord->sArea.sXMin + 1;
+		pulRecord += LCD_RECORD_WORDS((psRecord->usType == LCD_RECORD_PIXELS) ? ulLength : 0);
+
+		sPart.sXMin = (psRecord->sArea.sXMin > pTile->sXMin) ? psRecord->sArea.sXMin : pTile->sXMin;
+		sPart.sYMin = (psRecord->sArea.sYMin > pTile->sYMin) ? psRecord->sArea.sYMin : pTile->sYMin;
+		sPart.sXMax = (psRecord->sArea.sXMax < pTile->sXMax) ? psRecord->sArea.sXMax : pTile->sXMax;
+		sPart.sYMax = (psRecord->sArea.sYMax < pTile->sYMax) ? psRecord->sArea.sYMax : pTile->sYMax;
+		if((sPart.sXMin > sPart.sXMax) || (sPart.sYMin > sPart.sYMax))
+		{
+			continue;
+		}
+
+		ulLength = sPart.sXMax - sPart.sXMin + 1;
+		for(lY = sPart.sYMin; lY <= sPart.sYMax; lY++)
+		{
+			ulBit = (lY - pTile->sYMin) * lStride + (sPart.sXMin - pTile->sXMin);
+			pusTile = g_pusTile + ulBit;
+			if(psRecord->usType == LCD_RECORD_PIXELS)
+			{
+				pusPixels = (const unsigned short *)(psRecord + 1) + (sPart.sXMin - psRecord->sArea.sXMin);
+				for(i = 0; i < ulLength; i++)
+				{
+					pusTile[i] = pusPixels[i];
+				}
+			}
+			else
+			{
+				for(i = 0; i < ulLength; i++)
+				{
+					pusTile[i] = psRecord->usColor;
+				}
+			}
+			LCDTileCover(ulBit, ulLength);
+		}
+	}
+
+	// Whole tile covered
+	for(i = 0; (i < ulPixels / 32) && (g_pulTileMask[i] == 0xffffffff); i++)
+	{
+	}
+	if((i == ulPixels / 32) && (!(ulPixels & 31) || (g_pulTileMask[i] == (1UL << (ulPixels & 31)) - 1)))
+	{
+		Adafruit320x240x16_ILI9325Blit(pTile, g_pusTile, lStride);
+		if(g_ulSpritesVisible)
+		{
+			LCDSpriteUpdate(pTile->sXMin, pTile->sYMin, pTile->sXMax, pTile->sYMax);
+		}
+		return;
+	}
+
+	// Covered runs of each row, pixels no record touched keep their content
+	for(lY = pTile->sYMin; lY <= pTile->sYMax; lY++)
+	{
+		ulBit = (lY - pTile->sYMin) * lStride;
+		lX = 0;
+		while(lX < lStride)
+		{
+			if(!((g_pulTileMask[(ulBit + lX) >> 5] >> ((ulBit + lX) & 31)) & 1))
+			{
+				lX++;
+				continue;
+			}
+
+			sPart.sXMin = pTile->sXMin + lX;
+			while((lX < lStride) && ((g_pulTileMask[(ulBit + lX) >> 5] >> ((ulBit + lX) & 31)) & 1))
+			{
+				lX++;
+			}
+			sPart.sXMax = pTile->sXMin + lX - 1;
+			sPart.sYMin = lY;
+			sPart.sYMax = lY;
+
+			Adafruit320x240x16_ILI9325Blit(&sPart, g_pusTile + ulBit + (sPart.sXMin - pTile->sXMin), lStride);
+			if(g_ulSpritesVisible)
+			{
+				LCDSpriteUpdate(sPart.sXMin, lY, sPart.sXMax, lY);
+			}
+		}
+	}
+}
+
+// Render all recorded primitives tile by tile and empty the list
+// Tiles are as wide as the recorded area or the tile buffer, and as high as the buffer allows
+static void LCDDeferRender(void)
+{
+	unsigned long ulWords = g_ulListUsed;
+	long lWidth, lLines;
+	tRectangle sTile;
+
+	if(!ulWords)
+	{
+		return;
+	}
+
+	// Drawing done by the renderer itself, e.g. of sprites, goes to the display directly
+	g_ulListUsed = 0;
+
+	lWidth = g_sDeferArea.sXMax - g_sDeferArea.sXMin + 1;
+	if(lWidth > (long)g_ulTilePixels)
+	{
+		lWidth = g_ulTilePixels;
+	}
+	lLines = g_ulTilePixels / lWidth;
+
+	for(sTile.sYMin = g_sDeferArea.sYMin; sTile.sYMin <= g_sDeferArea.sYMax; sTile.sYMin += lLines)
+	{
+		sTile.sYMax = sTile.sYMin + lLines - 1;
+		if(sTile.sYMax > g_sDeferArea.sYMax)
+		{
+			sTile.sYMax = g_sDeferArea.sYMax;
+		}
+
+		for(sTile.sXMin = g_sDeferArea.sXMin; sTile.sXMin <= g_sDeferArea.sXMax; sTile.sXMin += lWidth)
+		{
+			sTile.sXMax = sTile.sXMin + lWidth - 1;
+			if(sTile.sXMax > g_sDeferArea.sXMax)
+			{
+				sTile.sXMax = g_sDeferArea.sXMax;
+			}
+			LCDDeferTile(&sTile, ulWords);
+		}
+	}
+}
+
+// Append a record of ulWords words covering the area in display coordinates to the list
+// A full list is rendered first, returns 0 if the record does not fit into the empty list
+static tLCDRecord *LCDDeferRecord(unsigned long ulWords, long lX1, long lY1, long lX2, long lY2)
+{
+	tLCDRecord *psRecord;
+
+	if(g_ulListUsed + ulWords > g_ulListWords)
+	{
+		LCDDeferRender();
+		if(ulWords > g_ulListWords)
+		{
+			return 0;
+		}
+	}
+
+	if(!g_ulListUsed)
+	{
+		g_sDeferArea.sXMin = lX1;
+		g_sDeferArea.sYMin = lY1;
+		g_sDeferArea.sXMax = lX2;
+		g_sDeferArea.sYMax = lY2;
+	}
+	else
+	{
+		if(lX1 < g_sDeferArea.sXMin) g_sDeferArea.sXMin = lX1;
+		if(lY1 < g_sDeferArea.sYMin) g_sDeferArea.sYMin = lY1;
+		if(lX2 > g_sDeferArea.sXMax) g_sDeferArea.sXMax = lX2;
+		if(lY2 > g_sDeferArea.sYMax) g_sDeferArea.sYMax = lY2;
+	}
+
+	psRecord = (tLCDRecord *)(g_pulList + g_ulListUsed);
+	g_ulListUsed += ulWords;
+	psRecord->sArea.sXMin = lX1;
+	psRecord->sArea.sYMin = lY1;
+	psRecord->sArea.sXMax = lX2;
+	psRecord->sArea.sYMax = lY2;
+
+	return psRecord;
+}
+
+// Record a fill in display coordinates, returns false if it has to be drawn directly
+static tBoolean LCDDeferFill(long lX1, long lY1, long lX2, long lY2, unsigned long ulValue)
+{
+	tLCDRecord *psRecord = LCDDeferRecord(LCD_RECORD_WORDS(0), lX1, lY1, lX2, lY2);
+
+	if(!psRecord)
+	{
+		return false;
+	}
+	psRecord->usType = LCD_RECORD_FILL;
+	psRecord->usColor = ulValue;
+	return true;
+}
+
+// Record a row of pixels of PixelDrawMultiple, returns false if it has to be drawn directly
+static tBoolean LCDDeferPixels(long lX, long lY, long lX0, long lCount, long lBPP,
+							   const unsigned char *pucData, const unsigned char *pucPalette)
+{
+	tLCDRecord *psRecord = LCDDeferRecord(LCD_RECORD_WORDS(lCount), lX, lY, lX + lCount - 1, lY);
+
+	if(!psRecord)
+	{
+		return false;
+	}
+	psRecord->usType = LCD_RECORD_PIXELS;
+	LCDPixelExpand(lX0, lCount, lBPP, pucData, pucPalette, (unsigned short *)(psRecord + 1));
+	return true;
+}
+
+// Start deferred rendering, grlib primitives are recorded until GrFlush or Adafruit320x240x16_ILI9325DeferEnd
+// ImageDraw and StringDraw are drawn through grlib and recorded as well. Blit, BusImageDraw, RectCopy and
+// the sprite functions write to the display directly after rendering the recorded primitives, so they
+// keep their order but the pixels they overlap are written twice. Use them between frames instead.
+// pulTile holds the tile buffer of ulTileBytes, see ADAFRUIT_ILI9325_TILE_BYTES, and pulList the record
+// list of ulListBytes. A pixel row of PixelDrawMultiple takes 12 bytes plus 2 per pixel, all other
+// primitives 12 bytes. A full list is rendered before recording continues.
+void Adafruit320x240x16_ILI9325DeferBegin(unsigned long *pulTile, unsigned long ulTileBytes,
+										  unsigned long *pulList, unsigned long ulListBytes)
+{
+	LCDPixelQueueSubmit();
+	LCDDeferRender();
+
+	// Tile pixels in multiples of 32, each taking 2 bytes and a bit of the mask in front
+	g_ulTilePixels = ulTileBytes / 68 * 32;
+	g_pulTileMask = pulTile;
+	g_pusTile = (unsigned short *)(pulTile + g_ulTilePixels / 32);
+	g_pulList = pulList;
+	g_ulListWords = ulListBytes / 4;
+	g_ulListUsed = 0;
+	g_bDefer = (g_ulTilePixels != 0);
+}
+
+// Render recorded primitives and return to drawing directly
+void Adafruit320x240x16_ILI9325DeferEnd(void)
+{
+	LCDDeferRender();
+	g_bDefer = false;
+}
+
+// Display list being recorded, 0 if primitives are drawn
+tILI9325List *g_psList;
+
+// Append a record of ulWords words covering the area in display coordinates to the recorded display list
+// Returns 0 and marks the list as incomplete if the record does not fit into the arena
+static tLCDRecord *LCDListRecord(unsigned long ulWords, long lX1, long lY1, long lX2, long lY2)
+{
+	tLCDRecord *psRecord;
+
+	if(g_psList->ulUsed + ulWords > g_psList->ulWords)
+	{
+		g_psList->bOverflow = true;
+		return 0;
+	}
+
+	psRecord = (tLCDRecord *)(g_psList->pulArena + g_psList->ulUsed);
+	g_psList->ulUsed += ulWords;
+	psRecord->sArea.sXMin = lX1;
+	psRecord->sArea.sYMin = lY1;
+	psRecord->sArea.sXMax = lX2;
+	psRecord->sArea.sYMax = lY2;
+
+	return psRecord;
+}
+
+// Record a fill in display coordinates into the display list
+static tBoolean LCDListFill(long lX1, long lY1, long lX2, long lY2, unsigned long ulValue)
+{
+	tLCDRecord *psRecord = LCDListRecord(LCD_RECORD_WORDS(0), lX1, lY1, lX2, lY2);
+
+	if(psRecord)
+	{
+		psRecord->usType = LCD_RECORD_FILL;
+		psRecord->usColor = ulValue;
+	}
+	return true;
+}
+
+// Record a row of pixels of PixelDrawMultiple into the display list
+static tBoolean LCDListPixels(long lX, long lY, long lX0, long lCount, long lBPP,
+							  const unsigned char *pucData, const unsigned char *pucPalette)
+{
+	tLCDRecord *psRecord = LCDListRecord(LCD_RECORD_WORDS(lCount), lX, lY, lX + lCount - 1, lY);
+
+	if(psRecord)
+	{
+		// Unused color and padding are zero, records are compared by word
+		psRecord->usType = LCD_RECORD_PIXELS;
+		psRecord->usColor = 0;
+		((unsigned long *)psRecord)[LCD_RECORD_WORDS(lCount) - 1] = 0;
+		LCDPixelExpand(lX0, lCount, lBPP, pucData, pucPalette, (unsigned short *)(psRecord + 1));
+	}
+	return true;
+}
+
+// Size of a record of a display list in words
+static unsigned long LCDRecordWords(const tLCDRecord *psRecord)
+{
+	return LCD_RECORD_WORDS((psRecord->usType == LCD_RECORD_PIXELS) ?
+							(psRecord->sArea.sXMax - psRecord->sArea.sXMin + 1) : 0);
+}
+
+// True if rectangle pOuter contains rectangle pInner
+static tBoolean LCDRectContains(const tRectangle *pOuter, const tRectangle *pInner)
+{
+	return ((pOuter->sXMin <= pInner->sXMin) && (pOuter->sYMin <= pInner->sYMin) &&
+			(pOuter->sXMax >= pInner->sXMax) && (pOuter->sYMax >= pInner->sYMax));
+}
+
+// Start recording the tDisplay calls of grlib into a display list instead of drawing them
+// ImageDraw and StringDraw are recorded as well. Blit, BusImageDraw, RectCopy and the sprite functions
+// write to the display directly and are not part of the list, they must not be used while recording.
+// Records are stored in pulArena of ulBytes, see Adafruit320x240x16_ILI9325DeferBegin for their size.
+// Primitives that do not fit are dropped and mark the list as incomplete.
+void Adafruit320x240x16_ILI9325ListBegin(tILI9325List *psList, unsigned long *pulArena, unsigned long ulBytes)
+{
+	LCDPixelQueueSubmit();
+
+	psList->pulArena = pulArena;
+	psList->ulWords = ulBytes / 4;
+	psList->ulUsed = 0;
+	psList->bOverflow = false;
+	g_psList = psList;
+}
+
+// Stop recording, returns false if the list is incomplete and the screen has to be painted directly
+// Records fully hidden by a later fill are removed, and a fill is merged with the fill recorded
+// before it if both have the same color and together form a rectangle.
+tBoolean Adafruit320x240x16_ILI9325ListEnd(void)
+{
+	tILI9325List *psList = g_psList;
+	unsigned long *pulEnd = psList->pulArena + psList->ulUsed;
+	unsigned long *pulRead, *pulLater, *pulWrite = psList->pulArena;
+	tLCDRecord *psRecord, *psLater, *psLast = 0;
+	unsigned long ulWords, i;
+
+	g_psList = 0;
+
+	for(pulRead = psList->pulArena; pulRead < pulEnd; pulRead += ulWords)
+	{
+		psRecord = (tLCDRecord *)pulRead;
+		ulWords = LCDRecordWords(psRecord);
+
+		// Hidden by a later fill
+		for(pulLater = pulRead + ulWords; pulLater < pulEnd; pulLater += LCDRecordWords(psLater))
+		{
+			psLater = (tLCDRecord *)pulLater;
+			if((psLater->usType == LCD_RECORD_FILL) && LCDRectContains(&psLater->sArea, &psRecord->sArea))
+			{
+				break;
+			}
+		}
+		if(pulLater < pulEnd)
+		{
+			continue;
+		}
+
+		// Adjacent to the previous fill of the same color
+		if(psLast && (psLast->usType == LCD_RECORD_FILL) && (psRecord->usType == LCD_RECORD_FILL) &&
+		   (psLast->usColor == psRecord->usColor))
+		{
+			if((psLast->sArea.sYMin == psRecord->sArea.sYMin) && (psLast->sArea.sYMax == psRecord->sArea.sYMax))
+			{
+				if(psLast->sArea.sXMax + 1 == psRecord->sArea.sXMin)
+				{
+					psLast->sArea.sXMax = psRecord->sArea.sXMax;
+					continue;
+				}
+				if(psRecord->sArea.sXMax + 1 == psLast->sArea.sXMin)
+				{
+					psLast->sArea.sXMin = psRecord->sArea.sXMin;
+					continue;
+				}
+			}
+			if((psLast->sArea.sXMin == psRecord->sArea.sXMin) && (psLast->sArea.sXMax == psRecord->sArea.sXMax))
+			{
+				if(psLast->sArea.sYMax + 1 == psRecord->sArea.sYMin)
+				{
+					psLast->sArea.sYMax = psRecord->sArea.sYMax;
+					continue;
+				}
+				if(psRecord->sArea.sYMax + 1 == psLast->sArea.sYMin)
+				{
+					psLast->sArea.sYMin = psRecord->sArea.sYMin;
+					continue;
+				}
+			}
+		}
+
+		// Keep record, moved down over removed ones
+		psLast = (tLCDRecord *)pulWrite;
+		for(i = 0; i < ulWords; i++)
+		{
+			pulWrite[i] = pulRead[i];
+		}
+		pulWrite += ulWords;
+	}
+	psList->ulUsed = pulWrite - psList->pulArena;
+
+	return !psList->bOverflow;
+}
+
+// Primitives for portrait and landscape orientations are built from the following
+// functions, inlined with a constant bLandscape. Orientations rotated by 180 degrees
+// share the same primitives as mirroring is done by the scan direction of the controller.
+
+static inline void LCDPixelDraw(long lX, long lY, unsigned long ulValue, const tBoolean bLandscape)
+{
+	if(g_psList && LCDListFill(lX, lY, lX, lY, ulValue))
+	{
+		return;
+	}
+	if(g_bDefer && LCDDeferFill(lX, lY, lX, lY, ulValue))
+	{
+		return;
+	}
+
+	// Collected into runs, see LCDPixelQueueSubmit
+	LCDPixelQueueAdd(lX, lY, ulValue);
+}
+
+static inline void LCDPixelDrawMultiple(long lX, long lY, long lX0, long lCount, long lBPP,
+										const unsigned char *pucData, const unsigned char *pucPalette,
+										const tBoolean bLandscape)
+{
+	// Pixels queued before go first
+	LCDPixelQueueSubmit();
+
+	long lH = bLandscape ? lY : lX;
+	long lV = bLandscape ? lX : lY;
+
+	if(g_psList && LCDListPixels(lX, lY, lX0, lCount, lBPP, pucData, pucPalette))
+	{
+		return;
+	}
+	if(g_bDefer && LCDDeferPixels(lX, lY, lX0, lCount, lBPP, pucData, pucPalette))
+	{
+		return;
+	}
+
+	// Start talking to LCD
+	LCDSessionBegin();
+
+	// Configure write direction to horizontal in display coordinates
+	LCDWriteRegister(ILI_ENTRY_MOD, bLandscape ? ILI_ENTRY_MOD_VER : ILI_ENTRY_MOD_HOR);
+
+	if((lX == g_lRowX) && (lY == g_lRowY + 1) && (lCount == g_lRowCount))
+	{
+		// Next row of an image, restrict window to the width of the row so the
+		// address counter wraps to the start of the following row by itself
+		tRectangle sRow;
+		if(bLandscape)
+		{
+			sRow.sXMin = 0;
+			sRow.sYMin = lV;
+			sRow.sXMax = LCD_X - 1;
+			sRow.sYMax = lV + lCount - 1;
+		}
+		else
+		{
+			sRow.sXMin = lH;
+			sRow.sYMin = 0;
+			sRow.sXMax = lH + lCount - 1;
+			sRow.sYMax = LCD_Y - 1;
+		}
+		LCDWindowSet(&sRow);
+	}
+	else if(bLandscape)
+	{
+		LCDWindowCover(lH, lV, lH, lV + lCount - 1);
+	}
+	else
+	{
+		LCDWindowCover(lH, lV, lH + lCount - 1, lV);
+	}
+	g_lRowX = lX;
+	g_lRowY = lY;
+	g_lRowCount = lCount;
+
+	LCDGoto(lH, lV);
+
+	LCDBurstBegin();
+	LCDPixelStream(lX0, lCount, lBPP, pucData, pucPalette);
+	LCDBurstEnd(lCount);
+
+	// Done talking to LCD
+	LCDSessionEnd();
+
+	// Draw sprites again over new pixels
+	if(g_ulSpritesVisible)
+	{
+		LCDSpriteUpdate(lX, lY, lX + lCount - 1, lY);
+	}
+}
+
+static inline void LCDLineDrawH(long lX1, long lX2, long lY, unsigned long ulValue, const tBoolean bLandscape)
+{
+	// Pixels queued before go first
+	LCDPixelQueueSubmit();
+
+	if(g_psList && LCDListFill(lX1, lY, lX2, lY, ulValue))
+	{
+		return;
+	}
+	if(g_bDefer && LCDDeferFill(lX1, lY, lX2, lY, ulValue))
+	{
+		return;
+	}
+
+	// Start talking to LCD
+	LCDSessionBegin();
+
+	// Configure write direction to horizontal in display coordinates
+	if(bLandscape)
+	{
+		LCDWriteRegister(ILI_ENTRY_MOD, ILI_ENTRY_MOD_VER);
+		LCDWindowCover(lY, lX1, lY, lX2);
+		LCDGoto(lY, lX1);
+	}
+	else
+	{
+		LCDWriteRegister(ILI_ENTRY_MOD, ILI_ENTRY_MOD_HOR);
+		LCDWindowCover(lX1, lY, lX2, lY);
+		LCDGoto(lX1, lY);
+	}
+
+	LCDBurstBegin();
+	LCDBurstRepeat(ulValue, lX2 - lX1 + 1);
+	LCDBurstEnd(lX2 - lX1 + 1);
+
+	// Done talking to LCD
+	LCDSessionEnd();
+
+	// Draw sprites again over new pixels
+	if(g_ulSpritesVisible)
+	{
+		LCDSpriteUpdate(lX1, lY, lX2, lY);
+	}
+}
+
+static inline void LCDLineDrawV(long lX, long lY1, long lY2, unsigned long ulValue, const tBoolean bLandscape)
+{
+	// Pixels queued before go first
+	LCDPixelQueueSubmit();
+
+	if(g_psList && LCDListFill(lX, lY1, lX, lY2, ulValue))
+	{
+		return;
+	}
+	if(g_bDefer && LCDDeferFill(lX, lY1, lX, lY2, ulValue))
+	{
+		return;
+	}
+
+	// Start talking to LCD
+	LCDSessionBegin();
+
+	// Configure write direction to vertical in display coordinates
+	if(bLandscape)
+	{
+		LCDWriteRegister(ILI_ENTRY_MOD, ILI_ENTRY_MOD_HOR);
+		LCDWindowCover(lY1, lX, lY2, lX);
+		LCDGoto(lY1, lX);
+	}
+	else
+	{
+		LCDWriteRegister(ILI_ENTRY_MOD, ILI_ENTRY_MOD_VER);
+		LCDWindowCover(lX, lY1, lX, lY2);
+		LCDGoto(lX, lY1);
+	}
+
+	LCDBurstBegin();
+	LCDBurstRepeat(ulValue, lY2 - lY1 + 1);
+	LCDBurstEnd(lY2 - lY1 + 1);
+
+	// Done talking to LCD
+	LCDSessionEnd();
+
+	// Draw sprites again over new pixels
+	if(g_ulSpritesVisible)
+	{
+		LCDSpriteUpdate(lX, lY1, lX, lY2);
+	}
+}
+
+static inline void LCDRectFill(const tRectangle *pRect, unsigned long ulValue, const tBoolean bLandscape)
+{
+	// Pixels queued before go first
+	LCDPixelQueueSubmit();
+
+	tRectangle sGram;
+
+	if(g_psList && LCDListFill(pRect->sXMin, pRect->sYMin, pRect->sXMax, pRect->sYMax, ulValue))
+	{
+		return;
+	}
+	if(g_bDefer && LCDDeferFill(pRect->sXMin, pRect->sYMin, pRect->sXMax, pRect->sYMax, ulValue))
+	{
+		return;
+	}
+
+	// Start talking to LCD
+	LCDSessionBegin();
+
+	if(bLandscape)
+	{
+		sGram.sXMin = pRect->sYMin;
+		sGram.sYMin = pRect->sXMin;
+		sGram.sXMax = pRect->sYMax;
+		sGram.sYMax = pRect->sXMax;
+		LCDAddressWindow(&sGram);
+	}
+	else
+	{
+		LCDAddressWindow(pRect);
+	}
+
+	int pixel = (pRect->sXMax - pRect->sXMin + 1) * (pRect->sYMax - pRect->sYMin + 1);	// bug fix by jks-liu on github
+
+	LCDBurstBegin();
+	LCDBurstRepeat(ulValue, pixel);
+	LCDBurstEnd(pixel);
+
+	// Done talking to LCD
+	LCDSessionEnd();
+
+	// Draw sprites again over new pixels
+	if(g_ulSpritesVisible)
+	{
+		LCDSpriteUpdate(pRect->sXMin, pRect->sYMin, pRect->sXMax, pRect->sYMax);
+	}
+}
+
+void Adafruit320x240x16_ILI9325PixelDrawPortrait(void *pvDisplayData, long lX, long lY, unsigned long ulValue)
+{
+	LCDPixelDraw(lX, lY, ulValue, false);
+}
+
+void Adafruit320x240x16_ILI9325PixelDrawLandscape(void *pvDisplayData, long lX, long lY, unsigned long ulValue)
+{
+	LCDPixelDraw(lX, lY, ulValue, true);
+}
+
+void Adafruit320x240x16_ILI9325PixelDrawMultiplePortrait(void *pvDisplayData,
+														 long lX, long lY, long lX0, long lCount, long lBPP,
+														 const unsigned char *pucData,
+														 const unsigned char *pucPalette)
+{
+	LCDPixelDrawMultiple(lX, lY, lX0, lCount, lBPP, pucData, pucPalette, false);
+}
+
+void Adafruit320x240x16_ILI9325PixelDrawMultipleLandscape(void *pvDisplayData,
+														  long lX, long lY, long lX0, long lCount, long lBPP,
+														  const unsigned char *pucData,
+														  const unsigned char *pucPalette)
+{
+	LCDPixelDrawMultiple(lX, lY, lX0, lCount, lBPP, pucData, pucPalette, true);
+}
+
+void Adafruit320x240x16_ILI9325LineDrawHPortrait(void *pvDisplayData,
+												 long lX1, long lX2, long lY, unsigned long ulValue)
+{
+	LCDLineDrawH(lX1, lX2, lY, ulValue, false);
+}
+
+void Adafruit320x240x16_ILI9325LineDrawHLandscape(void *pvDisplayData,
+												  long lX1, long lX2, long lY, unsigned long ulValue)
+{
+	LCDLineDrawH(lX1, lX2, lY, ulValue, true);
+}
+
+void Adafruit320x240x16_ILI9325LineDrawVPortrait(void *pvDisplayData,
+												 long lX, long lY1, long lY2, unsigned long ulValue)
+{
+	LCDLineDrawV(lX, lY1, lY2, ulValue, false);
+}
+
+void Adafruit320x240x16_ILI9325LineDrawVLandscape(void *pvDisplayData,
+												  long lX, long lY1, long lY2, unsigned long ulValue)
+{
+	LCDLineDrawV(lX, lY1, lY2, ulValue, true);
+}
+
+void Adafruit320x240x16_ILI9325RectFillPortrait(void *pvDisplayData,
+												const tRectangle *pRect, unsigned long ulValue)
+{
+	LCDRectFill(pRect, ulValue, false);
+}
+
+void Adafruit320x240x16_ILI9325RectFillLandscape(void *pvDisplayData,
+												 const tRectangle *pRect, unsigned long ulValue)
+{
+	LCDRectFill(pRect, ulValue, true);
+}
+
+static unsigned long Adafruit320x240x16_ILI9325ColorTranslate(void *pvDisplayData, unsigned long ulValue)
 {
     //
     // Translate from a 24-bit RGB color to a 5-6-5 RGB color.
@@ -603,23 +2359,1301 @@ static unsigned long Adafruit320x240x16_ILI9325ColorTranslate(void *pvDisplayDat
     return(COLOR24TO16BIT(ulValue));
 }
 
-static void Adafruit320x240x16_ILI9325Flush(void *pvDisplayData)
+static void Adafruit320x240x16_ILI9325Flush(void *pvDisplayData)
+{
+    // Draw queued pixels and render primitives recorded in deferred mode, others are written directly to display
+    LCDPixelQueueSubmit();
+    LCDDeferRender();
+
+    // End a batched session
+    LCDSessionClose();
+}
+
+// Open address window on a rectangle in display coordinates of the active orientation,
+// with the write direction set to rows of the display
+static void LCDDisplayWindow(const tRectangle *pRect)
+{
+	tRectangle sGram;
+
+	// Rows in display coordinates are horizontal in portrait and vertical in landscape GRAM
+	if(g_ulRotation & 1)
+	{
+		LCDWriteRegister(ILI_ENTRY_MOD, ILI_ENTRY_MOD_VER);
+		sGram.sXMin = pRect->sYMin;
+		sGram.sYMin = pRect->sXMin;
+		sGram.sXMax = pRect->sYMax;
+		sGram.sYMax = pRect->sXMax;
+	}
+	else
+	{
+		LCDWriteRegister(ILI_ENTRY_MOD, ILI_ENTRY_MOD_HOR);
+		sGram = *pRect;
+	}
+	LCDAddressWindow(&sGram);
+}
+
+// Copy rectangle of RGB565 pixels in the active orientation to the display
+// pRect must lie within the display, lStride is the distance between rows of pusData in pixels
+// Rows of the buffer are streamed into one address window without setting an address per row
+void Adafruit320x240x16_ILI9325Blit(const tRectangle *pRect, const unsigned short *pusData, long lStride)
+{
+	long lWidth = pRect->sXMax - pRect->sXMin + 1;
+	long lHeight = pRect->sYMax - pRect->sYMin + 1;
+
+	// Draw queued pixels and recorded primitives first
+	LCDPixelQueueSubmit();
+	LCDDeferRender();
+
+	// Start talking to LCD
+	LCDSessionBegin();
+
+	LCDDisplayWindow(pRect);
+
+	LCDBurstBegin();
+	if(lStride == lWidth)
+	{
+		LCDBurstWrite(pusData, lWidth * lHeight);
+	}
+	else
+	{
+		long lRow;
+		for(lRow = 0; lRow < lHeight; lRow++)
+		{
+			LCDBurstWrite(pusData, lWidth);
+			pusData += lStride;
+		}
+	}
+	LCDBurstEnd(lWidth * lHeight);
+
+	// Done talking to LCD
+	LCDSessionEnd();
+}
+
+// Areas redrawn by Adafruit320x240x16_ILI9325ListReplayChanged, a new area is merged into the
+// area it enlarges least once all are used
+#define LCD_LIST_DIRTY_AREAS	8
+static tRectangle g_psDirty[LCD_LIST_DIRTY_AREAS];
+static unsigned long g_ulDirtyCount;
+
+// Add an area to the redrawn areas
+static void LCDDirtyAdd(const tRectangle *pRect)
+{
+	unsigned long ulBest = 0, ulGrowth, ulBestGrowth = 0xffffffff, i;
+	tRectangle sUnion, *pDirty;
+
+	if(g_ulDirtyCount < LCD_LIST_DIRTY_AREAS)
+	{
+		g_psDirty[g_ulDirtyCount++] = *pRect;
+		return;
+	}
+
+	for(i = 0; i < LCD_LIST_DIRTY_AREAS; i++)
+	{
+		pDirty = &g_psDirty[i];
+		sUnion.sXMin = (pRect->sXMin < pDirty->sXMin) ? pRect->sXMin : pDirty->sXMin;
+		sUnion.sYMin = (pRect->sYMin < pDirty->sYMin) ? pRect->sYMin : pDirty->sYMin;
+		sUnion.sXMax = (pRect->sXMax > pDirty->sXMax) ? pRect->sXMax : pDirty->sXMax;
+		sUnion.sYMax = (pRect->sYMax > pDirty->sYMax) ? pRect->sYMax : pDirty->sYMax;
+		ulGrowth = (sUnion.sXMax - sUnion.sXMin + 1) * (sUnion.sYMax - sUnion.sYMin + 1) -
+				   (pDirty->sXMax - pDirty->sXMin + 1) * (pDirty->sYMax - pDirty->sYMin + 1);
+		if(ulGrowth < ulBestGrowth)
+		{
+			ulBestGrowth = ulGrowth;
+			ulBest = i;
+		}
+	}
+
+	pDirty = &g_psDirty[ulBest];
+	if(pRect->sXMin < pDirty->sXMin) pDirty->sXMin = pRect->sXMin;
+	if(pRect->sYMin < pDirty->sYMin) pDirty->sYMin = pRect->sYMin;
+	if(pRect->sXMax > pDirty->sXMax) pDirty->sXMax = pRect->sXMax;
+	if(pRect->sYMax > pDirty->sYMax) pDirty->sYMax = pRect->sYMax;
+}
+
+// True if an area overlaps a redrawn area
+static tBoolean LCDDirtyHit(const tRectangle *pRect)
+{
+	unsigned long i;
+
+	for(i = 0; i < g_ulDirtyCount; i++)
+	{
+		if((pRect->sXMin <= g_psDirty[i].sXMax) && (pRect->sXMax >= g_psDirty[i].sXMin) &&
+		   (pRect->sYMin <= g_psDirty[i].sYMax) && (pRect->sYMax >= g_psDirty[i].sYMin))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+// True if two records of display lists draw the same
+static tBoolean LCDRecordEqual(const unsigned long *pulA, const unsigned long *pulB)
+{
+	unsigned long ulWords = LCDRecordWords((const tLCDRecord *)pulA), i;
+
+	for(i = 0; i < ulWords; i++)
+	{
+		if(pulA[i] != pulB[i])
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// Draw a record of a display list in the active orientation
+static void LCDRecordDraw(const tLCDRecord *psRecord)
+{
+	if(psRecord->usType == LCD_RECORD_PIXELS)
+	{
+		Adafruit320x240x16_ILI9325Blit(&psRecord->sArea, (const unsigned short *)(psRecord + 1),
+									   psRecord->sArea.sXMax - psRecord->sArea.sXMin + 1);
+
+		// Draw sprites again over new pixels
+		if(g_ulSpritesVisible)
+		{
+			LCDSpriteUpdate(psRecord->sArea.sXMin, psRecord->sArea.sYMin, psRecord->sArea.sXMax, psRecord->sArea.sYMax);
+		}
+	}
+	else
+	{
+		LCDRectFill(&psRecord->sArea, psRecord->usColor, (g_ulRotation & 1) ? true : false);
+	}
+}
+
+// Draw all records of a display list
+void Adafruit320x240x16_ILI9325ListReplay(const tILI9325List *psList)
+{
+	const unsigned long *pulRecord = psList->pulArena;
+
+	while(pulRecord < psList->pulArena + psList->ulUsed)
+	{
+		LCDRecordDraw((const tLCDRecord *)pulRecord);
+		pulRecord += LCDRecordWords((const tLCDRecord *)pulRecord);
+	}
+}
+
+// Draw the records of a display list that differ from the list of the previous frame on screen
+// Records are compared by position in the lists. Areas of changed records of either list are redrawn,
+// together with every record overlapping them to keep the order in which records cover each other.
+// Without a complete previous list all records are drawn.
+void Adafruit320x240x16_ILI9325ListReplayChanged(const tILI9325List *psList, const tILI9325List *psPrevious)
+{
+	const unsigned long *pulEnd = psList->pulArena + psList->ulUsed;
+	const unsigned long *pulPreviousEnd, *pulRecord, *pulPrevious;
+	const tLCDRecord *psRecord;
+	tBoolean bChanged;
+
+	if(!psPrevious || psPrevious->bOverflow)
+	{
+		Adafruit320x240x16_ILI9325ListReplay(psList);
+		return;
+	}
+	pulPreviousEnd = psPrevious->pulArena + psPrevious->ulUsed;
+
+	// Areas of previous records that are gone have to be painted over
+	g_ulDirtyCount = 0;
+	pulRecord = psList->pulArena;
+	for(pulPrevious = psPrevious->pulArena; pulPrevious < pulPreviousEnd;
+		pulPrevious += LCDRecordWords((const tLCDRecord *)pulPrevious))
+	{
+		if((pulRecord >= pulEnd) || !LCDRecordEqual(pulRecord, pulPrevious))
+		{
+			LCDDirtyAdd(&((const tLCDRecord *)pulPrevious)->sArea);
+		}
+		if(pulRecord < pulEnd)
+		{
+			pulRecord += LCDRecordWords((const tLCDRecord *)pulRecord);
+		}
+	}
+
+	pulPrevious = psPrevious->pulArena;
+	for(pulRecord = psList->pulArena; pulRecord < pulEnd; pulRecord += LCDRecordWords(psRecord))
+	{
+		psRecord = (const tLCDRecord *)pulRecord;
+		bChanged = (pulPrevious >= pulPreviousEnd) || !LCDRecordEqual(pulRecord, pulPrevious);
+		if(pulPrevious < pulPreviousEnd)
+		{
+			pulPrevious += LCDRecordWords((const tLCDRecord *)pulPrevious);
+		}
+
+		if(bChanged || LCDDirtyHit(&psRecord->sArea))
+		{
+			LCDRecordDraw(psRecord);
+			LCDDirtyAdd(&psRecord->sArea);
+		}
+	}
+}
+
+// Read rectangle of pixels in the active orientation from the display into an RGB565 buffer
+// pRect must lie within the display, lStride is the distance between rows of pusData in pixels
+void Adafruit320x240x16_ILI9325RectRead(const tRectangle *pRect, unsigned short *pusData, long lStride)
+{
+	long lWidth = pRect->sXMax - pRect->sXMin + 1;
+	long lHeight = pRect->sYMax - pRect->sYMin + 1;
+	long lRow, lCol;
+
+	// Draw queued pixels and recorded primitives first
+	LCDPixelQueueSubmit();
+	LCDDeferRender();
+
+	// Start talking to LCD
+	LCDSessionBegin();
+
+	// Address is always written, reading GRAM starts with a dummy read after setting it
+	g_pusShadow[LCD_SHADOW_GRAM_HOR_AD] = LCD_SHADOW_INVALID;
+	g_pusShadow[LCD_SHADOW_GRAM_VER_AD] = LCD_SHADOW_INVALID;
+	LCDDisplayWindow(pRect);
+
+	LCDReadBegin();
+	LCDReadWord();
+	for(lRow = 0; lRow < lHeight; lRow++)
+	{
+		for(lCol = 0; lCol < lWidth; lCol++)
+		{
+			pusData[lCol] = LCDReadWord();
+		}
+		pusData += lStride;
+	}
+	LCDReadEnd();
+
+	// Done talking to LCD
+	LCDSessionEnd();
+}
+
+// Read RGB565 color of pixel at lX/lY in the active orientation
+unsigned short Adafruit320x240x16_ILI9325PixelRead(long lX, long lY)
+{
+	tRectangle sRect;
+	unsigned short usColor;
+
+	sRect.sXMin = lX;
+	sRect.sYMin = lY;
+	sRect.sXMax = lX;
+	sRect.sYMax = lY;
+	Adafruit320x240x16_ILI9325RectRead(&sRect, &usColor, 1);
+
+	return usColor;
+}
+
+// Read controller register ucAddress, e.g. 0x00 returns the device code 0x9325
+unsigned short Adafruit320x240x16_ILI9325RegisterRead(unsigned char ucAddress)
+{
+	unsigned short usData;
+
+	// Start talking to LCD
+	LCDSessionBegin();
+
+	LCDWriteCommand(ucAddress);
+	LCDReadBegin();
+	usData = LCDReadWord();
+	LCDReadEnd();
+
+	// Done talking to LCD
+	LCDSessionEnd();
+
+	return usData;
+}
+
+// Copy rectangle pSrc of the display to top left corner lX/lY, in the active orientation
+// Source and destination are clipped to the display and may overlap in any direction.
+// Pixels are moved in chunks of whole rows, or parts of a row if it is longer than the copy
+// buffer. Chunks are ordered so that no source pixel is overwritten before it was read.
+void Adafruit320x240x16_ILI9325RectCopy(const tRectangle *pSrc, long lX, long lY)
+{
+	long lDisplayWidth = (g_ulRotation & 1) ? LCD_Y : LCD_X;
+	long lDisplayHeight = (g_ulRotation & 1) ? LCD_X : LCD_Y;
+	long lDX = lX - pSrc->sXMin;
+	long lDY = lY - pSrc->sYMin;
+	long lWidth, lHeight, lRows, lCols, lRow, lCol, lStep;
+	tRectangle sSrc, sChunk, sDest;
+
+	// Part of source that is on the display and copied to the display
+	sSrc.sXMin = (pSrc->sXMin > 0) ? pSrc->sXMin : 0;
+	sSrc.sYMin = (pSrc->sYMin > 0) ? pSrc->sYMin : 0;
+	sSrc.sXMax = (pSrc->sXMax < lDisplayWidth - 1) ? pSrc->sXMax : lDisplayWidth - 1;
+	sSrc.sYMax = (pSrc->sYMax < lDisplayHeight - 1) ? pSrc->sYMax : lDisplayHeight - 1;
+	if(sSrc.sXMin < -lDX) sSrc.sXMin = -lDX;
+	if(sSrc.sYMin < -lDY) sSrc.sYMin = -lDY;
+	if(sSrc.sXMax > lDisplayWidth - 1 - lDX) sSrc.sXMax = lDisplayWidth - 1 - lDX;
+	if(sSrc.sYMax > lDisplayHeight - 1 - lDY) sSrc.sYMax = lDisplayHeight - 1 - lDY;
+	if((sSrc.sXMin > sSrc.sXMax) || (sSrc.sYMin > sSrc.sYMax))
+	{
+		return;
+	}
+	lWidth = sSrc.sXMax - sSrc.sXMin + 1;
+	lHeight = sSrc.sYMax - sSrc.sYMin + 1;
+
+	// Draw queued pixels and recorded primitives first
+	LCDPixelQueueSubmit();
+	LCDDeferRender();
+
+	// Whole rows per chunk, or parts of a single row
+	lRows = LCD_COPY_PIXELS / lWidth;
+	lCols = lWidth;
+	if(!lRows)
+	{
+		lRows = 1;
+		lCols = LCD_COPY_PIXELS;
+	}
+
+	// Move down: start at the bottom, move up or sideways: start at the top
+	lStep = (lDY > 0) ? -lRows : lRows;
+	lRow = (lDY > 0) ? lHeight - lRows : 0;
+
+	for(; (lRow > -lRows) && (lRow < lHeight); lRow += lStep)
+	{
+		sChunk.sYMin = sSrc.sYMin + ((lRow > 0) ? lRow : 0);
+		sChunk.sYMax = sSrc.sYMin + ((lRow + lRows < lHeight) ? lRow + lRows : lHeight) - 1;
+
+		// Within a row, move right: start at the right end, otherwise at the left end
+		for(lCol = 0; lCol < lWidth; lCol += lCols)
+		{
+			if(lDX > 0)
+			{
+				sChunk.sXMax = sSrc.sXMax - lCol;
+				sChunk.sXMin = (sChunk.sXMax - lCols + 1 > sSrc.sXMin) ? sChunk.sXMax - lCols + 1 : sSrc.sXMin;
+			}
+			else
+			{
+				sChunk.sXMin = sSrc.sXMin + lCol;
+				sChunk.sXMax = (sChunk.sXMin + lCols - 1 < sSrc.sXMax) ? sChunk.sXMin + lCols - 1 : sSrc.sXMax;
+			}
+
+			sDest.sXMin = sChunk.sXMin + lDX;
+			sDest.sYMin = sChunk.sYMin + lDY;
+			sDest.sXMax = sChunk.sXMax + lDX;
+			sDest.sYMax = sChunk.sYMax + lDY;
+
+			Adafruit320x240x16_ILI9325RectRead(&sChunk, g_pusCopy, sChunk.sXMax - sChunk.sXMin + 1);
+			Adafruit320x240x16_ILI9325Blit(&sDest, g_pusCopy, sChunk.sXMax - sChunk.sXMin + 1);
+		}
+	}
+}
+
+// Show sprite ulSprite with image psImage at lX/lY in the active orientation, or move it there
+// The pixels under the sprite are read back and restored when the sprite is moved or hidden.
+// Drawing with the grlib primitives and the image functions keeps sprites on top, while Blit and
+// RectCopy see sprites as part of the display content. Sprites must not overlap each other.
+// Returns false if the visible part of the image is larger than LCD_SPRITE_PIXELS.
+tBoolean Adafruit320x240x16_ILI9325SpriteShow(unsigned long ulSprite, const tILI9325Sprite *psImage, long lX, long lY)
+{
+	tLCDSprite *psSprite = &g_psSprites[ulSprite];
+	long lWidth = (g_ulRotation & 1) ? LCD_Y : LCD_X;
+	long lHeight = (g_ulRotation & 1) ? LCD_X : LCD_Y;
+	tRectangle sUnder;
+
+	// Draw queued pixels and recorded primitives first
+	LCDPixelQueueSubmit();
+	LCDDeferRender();
+
+	// Visible part of image
+	sUnder.sXMin = (lX > 0) ? lX : 0;
+	sUnder.sYMin = (lY > 0) ? lY : 0;
+	sUnder.sXMax = (lX + psImage->usWidth - 1 < lWidth - 1) ? lX + psImage->usWidth - 1 : lWidth - 1;
+	sUnder.sYMax = (lY + psImage->usHeight - 1 < lHeight - 1) ? lY + psImage->usHeight - 1 : lHeight - 1;
+	if((sUnder.sXMin > sUnder.sXMax) || (sUnder.sYMin > sUnder.sYMax))
+	{
+		// Outside of display, restore pixels at old position and keep sprite hidden
+		Adafruit320x240x16_ILI9325SpriteHide(ulSprite);
+		psSprite->psImage = psImage;
+		psSprite->lX = lX;
+		psSprite->lY = lY;
+		psSprite->sUnder = sUnder;
+		return true;
+	}
+	if((unsigned long)(sUnder.sXMax - sUnder.sXMin + 1) * (unsigned long)(sUnder.sYMax - sUnder.sYMin + 1) > LCD_SPRITE_PIXELS)
+	{
+		return false;
+	}
+
+	// Restore pixels at old position
+	Adafruit320x240x16_ILI9325SpriteHide(ulSprite);
+
+	psSprite->psImage = psImage;
+	psSprite->lX = lX;
+	psSprite->lY = lY;
+	psSprite->sUnder = sUnder;
+
+	// Save pixels at new position and draw sprite over them
+	Adafruit320x240x16_ILI9325RectRead(&sUnder, psSprite->pusUnder, sUnder.sXMax - sUnder.sXMin + 1);
+	LCDSpriteDraw(psSprite, &sUnder);
+	g_ulSpritesVisible |= (1 << ulSprite);
+
+	return true;
+}
+
+// Hide sprite ulSprite and restore the pixels under it
+void Adafruit320x240x16_ILI9325SpriteHide(unsigned long ulSprite)
+{
+	tLCDSprite *psSprite = &g_psSprites[ulSprite];
+
+	// Draw queued pixels and recorded primitives first
+	LCDPixelQueueSubmit();
+	LCDDeferRender();
+
+	if(g_ulSpritesVisible & (1 << ulSprite))
+	{
+		g_ulSpritesVisible &= ~(1 << ulSprite);
+		Adafruit320x240x16_ILI9325Blit(&psSprite->sUnder, psSprite->pusUnder,
+									   psSprite->sUnder.sXMax - psSprite->sUnder.sXMin + 1);
+	}
+}
+
+// Source of image data bytes, either read directly or decompressed from the LZSS stream
+// of the grlib compressed image formats. A flag byte precedes every group of 8 items, most
+// significant bit first. A clear flag marks a literal byte, a set flag an encoded byte
+// that copies (byte & 7) + 2 bytes starting (byte >> 3) + 1 bytes back in the last 32
+// decoded bytes.
+typedef struct
+{
+	const unsigned char *pucData;		// next byte of image data
+	tBoolean bCompressed;
+	unsigned long ulFlags;				// flags of current group, next flag in bit 7
+	unsigned long ulFlagCount;			// flags left in current group
+	unsigned long ulCopy;				// bytes left to copy from dictionary
+	unsigned long ulOffset;				// distance of copy in dictionary
+	unsigned long ulIndex;				// position of next decoded byte in dictionary
+	unsigned char pucDictionary[32];	// last 32 decoded bytes
+} tLCDImageSource;
+
+// Pixels of an image waiting to be written, runs of one palette index are collected
+// and written by the run fill engine, shorter runs are translated into a span for LCDBurstWrite
+#define LCD_IMAGE_SPAN		32		// pixels in span buffer
+#define LCD_IMAGE_RUN_MIN	4		// shortest run written by LCDBurstRepeat
+typedef struct
+{
+	const unsigned char *pucHigh;		// display colors of palette indices
+	const unsigned char *pucLow;
+	unsigned long ulRunIndex;			// palette index of current run
+	unsigned long ulRun;				// length of current run
+	unsigned long ulSpan;				// pixels in span buffer
+	unsigned short pusSpan[LCD_IMAGE_SPAN];
+} tLCDImageSink;
+
+// Return next byte of image data
+static unsigned long LCDImageByte(tLCDImageSource *psSource)
+{
+	unsigned long ulByte;
+
+	if(!psSource->bCompressed)
+	{
+		return *psSource->pucData++;
+	}
+
+	if(!psSource->ulCopy)
+	{
+		if(!psSource->ulFlagCount)
+		{
+			psSource->ulFlags = *psSource->pucData++;
+			psSource->ulFlagCount = 8;
+		}
+		psSource->ulFlagCount--;
+
+		ulByte = *psSource->pucData++;
+		if(!(psSource->ulFlags & 0x80))
+		{
+			// Literal byte
+			psSource->ulFlags <<= 1;
+			psSource->pucDictionary[psSource->ulIndex++ & 31] = ulByte;
+			return ulByte;
+		}
+
+		// Encoded byte, copy from dictionary
+		psSource->ulFlags <<= 1;
+		psSource->ulCopy = (ulByte & 7) + 2;
+		psSource->ulOffset = (ulByte >> 3) + 1;
+	}
+
+	psSource->ulCopy--;
+	ulByte = psSource->pucDictionary[(psSource->ulIndex - psSource->ulOffset) & 31];
+	psSource->pucDictionary[psSource->ulIndex++ & 31] = ulByte;
+	return ulByte;
+}
+
+// Write pending span of translated pixels
+static void LCDImageSpanFlush(tLCDImageSink *psSink)
+{
+	if(psSink->ulSpan)
+	{
+		LCDBurstWrite(psSink->pusSpan, psSink->ulSpan);
+		psSink->ulSpan = 0;
+	}
+}
+
+// Write current run, long runs by the run fill engine, short ones through the span
+static void LCDImageRunFlush(tLCDImageSink *psSink)
+{
+	unsigned long ulColor = (psSink->pucHigh[psSink->ulRunIndex] << 8) | psSink->pucLow[psSink->ulRunIndex];
+
+	if(psSink->ulRun >= LCD_IMAGE_RUN_MIN)
+	{
+		LCDImageSpanFlush(psSink);
+		LCDBurstRepeat(ulColor, psSink->ulRun);
+	}
+	else
+	{
+		while(psSink->ulRun--)
+		{
+			if(psSink->ulSpan == LCD_IMAGE_SPAN)
+			{
+				LCDImageSpanFlush(psSink);
+			}
+			psSink->pusSpan[psSink->ulSpan++] = ulColor;
+		}
+	}
+	psSink->ulRun = 0;
+}
+
+// Add ulCount pixels of palette index ulIndex
+static inline void LCDImagePixels(tLCDImageSink *psSink, unsigned long ulIndex, unsigned long ulCount)
+{
+	if(psSink->ulRun && (ulIndex != psSink->ulRunIndex))
+	{
+		LCDImageRunFlush(psSink);
+	}
+	psSink->ulRunIndex = ulIndex;
+	psSink->ulRun += ulCount;
+}
+
+// Draw image in grlib format at lX/lY, a replacement of GrImageDraw for contexts on this display
+// All uncompressed and compressed formats with 1, 4 and 8 bits per pixel are supported.
+// The image is decoded straight to the bus inside one address window, clipped to the clipping
+// region of pContext. Runs of one color are written as strobe-only fills.
+// In deferred mode and while a display list is recorded the image is drawn by grlib, so that its rows
+// are recorded like other primitives.
+void Adafruit320x240x16_ILI9325ImageDraw(const tContext *pContext, const unsigned char *pucImage, long lX, long lY)
+{
+	tLCDImageSource sSource;
+	tLCDImageSink sSink;
+	tRectangle sClip;
+	unsigned char pucMono[4];
+	unsigned long ulBPP, ulByte, ulMask, ulShift;
+	long lWidth, lHeight, lRowBytes, lRow, lCol, lCol1, lCol2, i;
+
+	if(g_bDefer || g_psList)
+	{
+		GrImageDraw(pContext, pucImage, lX, lY);
+		return;
+	}
+
+	// Draw queued pixels and recorded primitives first
+	LCDPixelQueueSubmit();
+	LCDDeferRender();
+
+	sSource.bCompressed = (pucImage[0] & 0x80) ? true : false;
+	ulBPP = pucImage[0] & 0x7f;
+	lWidth = pucImage[1] | (pucImage[2] << 8);
+	lHeight = pucImage[3] | (pucImage[4] << 8);
+	pucImage += 5;
+
+	// Pixels of a byte are decoded by shifting by the color depth, which must divide 8
+	if((ulBPP != 1) && (ulBPP != 4) && (ulBPP != 8))
+	{
+		return;
+	}
+
+	// Clip image to clipping region
+	sClip.sXMin = (lX > pContext->sClipRegion.sXMin) ? lX : pContext->sClipRegion.sXMin;
+	sClip.sYMin = (lY > pContext->sClipRegion.sYMin) ? lY : pContext->sClipRegion.sYMin;
+	sClip.sXMax = (lX + lWidth - 1 < pContext->sClipRegion.sXMax) ? lX + lWidth - 1 : pContext->sClipRegion.sXMax;
+	sClip.sYMax = (lY + lHeight - 1 < pContext->sClipRegion.sYMax) ? lY + lHeight - 1 : pContext->sClipRegion.sYMax;
+	if((sClip.sXMin > sClip.sXMax) || (sClip.sYMin > sClip.sYMax))
+	{
+		return;
+	}
+
+	// Palette of image, 1 bpp images are drawn in the colors of the context
+	if(ulBPP == 1)
+	{
+		pucMono[0] = pContext->ulBackground >> 8;
+		pucMono[1] = pContext->ulForeground >> 8;
+		pucMono[2] = pContext->ulBackground & 0xff;
+		pucMono[3] = pContext->ulForeground & 0xff;
+		sSink.pucHigh = pucMono;
+		sSink.pucLow = pucMono + 2;
+	}
+	else
+	{
+		// Entries given by the image, at most as many as the color depth can index
+		unsigned long ulEntries = pucImage[0] + 1;
+		const tLCDPalette *psPalette = LCDPaletteGet(pucImage + 1, ((ulBPP == 4) && (ulEntries > 16)) ? 16 : ulEntries);
+		sSink.pucHigh = psPalette->pucHigh;
+		sSink.pucLow = psPalette->pucLow;
+		pucImage += (pucImage[0] + 1) * 3 + 1;
+	}
+	sSink.ulRun = 0;
+	sSink.ulSpan = 0;
+
+	sSource.pucData = pucImage;
+	sSource.ulFlagCount = 0;
+	sSource.ulCopy = 0;
+	sSource.ulIndex = 0;
+
+	// Rows are padded to whole bytes, pixels start in the most significant bits
+	lRowBytes = (lWidth * ulBPP + 7) / 8;
+	ulMask = (1 << ulBPP) - 1;
+	lCol1 = sClip.sXMin - lX;
+	lCol2 = sClip.sXMax - lX;
+
+	// Skip rows above clipping region
+	for(lRow = lY; lRow < sClip.sYMin; lRow++)
+	{
+		if(sSource.bCompressed)
+		{
+			for(i = 0; i < lRowBytes; i++)
+			{
+				LCDImageByte(&sSource);
+			}
+		}
+		else
+		{
+			sSource.pucData += lRowBytes;
+		}
+	}
+
+	// Start talking to LCD
+	LCDSessionBegin();
+
+	LCDDisplayWindow(&sClip);
+
+	LCDBurstBegin();
+	for(; lRow <= sClip.sYMax; lRow++)
+	{
+		lCol = 0;
+		for(i = 0; i < lRowBytes; i++)
+		{
+			ulByte = LCDImageByte(&sSource);
+
+			if((ulBPP == 1) && ((ulByte == 0x00) || (ulByte == 0xff)) && (lCol >= lCol1) && (lCol + 7 <= lCol2))
+			{
+				// Solid byte of 1 bpp image
+				LCDImagePixels(&sSink, ulByte & 1, 8);
+				lCol += 8;
+				continue;
+			}
+
+			for(ulShift = 8; ulShift; lCol++)
+			{
+				ulShift -= ulBPP;
+				if((lCol >= lCol1) && (lCol <= lCol2))
+				{
+					LCDImagePixels(&sSink, (ulByte >> ulShift) & ulMask, 1);
+				}
+			}
+		}
+	}
+	if(sSink.ulRun)
+	{
+		LCDImageRunFlush(&sSink);
+	}
+	LCDImageSpanFlush(&sSink);
+	LCDBurstEnd((sClip.sXMax - sClip.sXMin + 1) * (sClip.sYMax - sClip.sYMin + 1));
+
+	// Done talking to LCD
+	LCDSessionEnd();
+
+	// Draw sprites again over new pixels
+	if(g_ulSpritesVisible)
+	{
+		LCDSpriteUpdate(sClip.sXMin, sClip.sYMin, sClip.sXMax, sClip.sYMax);
+	}
+}
+
+// Draw image in bus image format at lX/lY of the active orientation, the image must lie within the display
+// The format stores pixels already split into the bytes sent on the bus, see ADAFRUIT_ILI9325_BUSIMAGE
+// in the header file and the converter tools/ili9325img.py. Runs are written by the run fill engine,
+// literal pixels are copied from memory to the data port without translation.
+void Adafruit320x240x16_ILI9325BusImageDraw(const unsigned char *pucImage, long lX, long lY)
 {
-    // nothing to do as we write directly to display
+	tRectangle sRect;
+	unsigned long ulPixels, ulCount, ulHeader;
+
+	// Draw queued pixels and recorded primitives first
+	LCDPixelQueueSubmit();
+	LCDDeferRender();
+
+	sRect.sXMin = lX;
+	sRect.sYMin = lY;
+	sRect.sXMax = lX + (pucImage[1] | (pucImage[2] << 8)) - 1;
+	sRect.sYMax = lY + (pucImage[3] | (pucImage[4] << 8)) - 1;
+	ulPixels = (sRect.sXMax - sRect.sXMin + 1) * (sRect.sYMax - sRect.sYMin + 1);
+	pucImage += 5;
+
+	// Start talking to LCD
+	LCDSessionBegin();
+
+	LCDDisplayWindow(&sRect);
+
+	LCDBurstBegin();
+	for(ulCount = 0; ulCount < ulPixels; ulCount += (ulHeader & ADAFRUIT_ILI9325_BUSIMAGE_COUNT) + 1)
+	{
+		ulHeader = (pucImage[0] << 8) | pucImage[1];
+		if(ulHeader & ADAFRUIT_ILI9325_BUSIMAGE_RUN)
+		{
+			// Run of one color
+			LCDBurstRepeat((pucImage[2] << 8) | pucImage[3], (ulHeader & ADAFRUIT_ILI9325_BUSIMAGE_COUNT) + 1);
+			pucImage += 4;
+		}
+		else
+		{
+			// Literal pixels
+			LCDBurstBytes(pucImage + 2, ((ulHeader & ADAFRUIT_ILI9325_BUSIMAGE_COUNT) + 1) * 2);
+			pucImage += 2 + ((ulHeader & ADAFRUIT_ILI9325_BUSIMAGE_COUNT) + 1) * 2;
+		}
+	}
+	LCDBurstEnd(ulPixels);
+
+	// Done talking to LCD
+	LCDSessionEnd();
+
+	// Draw sprites again over new pixels
+	if(g_ulSpritesVisible)
+	{
+		LCDSpriteUpdate(sRect.sXMin, sRect.sYMin, sRect.sXMax, sRect.sYMax);
+	}
 }
 
-// grlib structure describing Adafruit 320x240x16 TFT Touch Display driver.
-const tDisplay g_sAdafruit320x240x16_ILI9325 =
+// Source of the pixels of a grlib font glyph
+// Uncompressed glyphs hold 1 bit per pixel, most significant bit first. Rows are not padded, a row
+// continues in the bits of the previous one.
+// Pixel RLE glyphs hold bytes with the number of background pixels in the upper and of foreground
+// pixels in the lower nibble. A zero byte is followed by a byte with 8 times the number of foreground
+// pixels if bit 7 is set, otherwise of background pixels. Rows are not padded.
+typedef struct
 {
-		sizeof(tDisplay),								// size of this structure
-		0,												// ptr to display specific data(?)
-		LCD_WIDTH,										// width in pixel
-		LCD_HEIGHT,										// height in pixel
-		Adafruit320x240x16_ILI9325PixelDraw,			// function to draw pixel
-		Adafruit320x240x16_ILI9325PixelDrawMultiple,	// function to draw multiple pixel
-		Adafruit320x240x16_ILI9325LineDrawH,			// function to draw horizontal line
-		Adafruit320x240x16_ILI9325LineDrawV,			// function to draw vertical line
-		Adafruit320x240x16_ILI9325RectFill,				// function to fill rectangle
-		Adafruit320x240x16_ILI9325ColorTranslate,		// function to translate 24bit color
-		Adafruit320x240x16_ILI9325Flush					// function to flush display writes
-};
+	const unsigned char *pucData;		// glyph, size in bytes and width followed by pixel data
+	tBoolean bCompressed;
+	unsigned long ulIndex;				// next byte of pixel data
+	unsigned long ulBit;				// next bit of uncompressed byte
+	unsigned long ulOff;				// background and foreground pixels left of RLE byte
+	unsigned long ulOn;
+	unsigned long ulRun;				// pixels left of run being streamed by LCDGlyphStream
+	tBoolean bRunOn;
+} tLCDGlyphSource;
+
+// Characters of a string written in one window by Adafruit320x240x16_ILI9325StringDraw
+#define LCD_STRING_CELL_CHARS	16
+static tLCDGlyphSource g_psCellSources[LCD_STRING_CELL_CHARS];
+
+// Start reading the glyph of ucChar
+static void LCDGlyphBegin(tLCDGlyphSource *psSource, const tFont *pFont, unsigned char ucChar)
+{
+	psSource->pucData = pFont->pucData + pFont->pusOffset[ucChar - ' '];
+	psSource->bCompressed = (pFont->ucFormat == FONT_FMT_PIXEL_RLE);
+	psSource->ulIndex = 2;
+	psSource->ulBit = 0;
+	psSource->ulOff = 0;
+	psSource->ulOn = 0;
+	psSource->ulRun = 0;
+}
+
+// Return the number of pixels of the next run of one color and set pbOn for foreground pixels
+// Returns 0 at the end of the data, remaining pixels of the glyph are background
+static unsigned long LCDGlyphRun(tLCDGlyphSource *psSource, tBoolean *pbOn)
+{
+	const unsigned char *pucData = psSource->pucData;
+	unsigned long ulRun = 0;
+
+	if(psSource->bCompressed)
+	{
+		while(!psSource->ulOff && !psSource->ulOn)
+		{
+			if(psSource->ulIndex >= pucData[0])
+			{
+				return 0;
+			}
+			if(pucData[psSource->ulIndex])
+			{
+				psSource->ulOff = pucData[psSource->ulIndex] >> 4;
+				psSource->ulOn = pucData[psSource->ulIndex] & 15;
+				psSource->ulIndex++;
+			}
+			else if(pucData[psSource->ulIndex + 1] & 0x80)
+			{
+				psSource->ulOn = (pucData[psSource->ulIndex + 1] & 0x7f) * 8;
+				psSource->ulIndex += 2;
+			}
+			else
+			{
+				psSource->ulOff = pucData[psSource->ulIndex + 1] * 8;
+				psSource->ulIndex += 2;
+			}
+		}
+
+		*pbOn = !psSource->ulOff;
+		ulRun = psSource->ulOff ? psSource->ulOff : psSource->ulOn;
+		if(psSource->ulOff)
+		{
+			psSource->ulOff = 0;
+		}
+		else
+		{
+			psSource->ulOn = 0;
+		}
+		return ulRun;
+	}
+
+	if(psSource->ulIndex >= pucData[0])
+	{
+		return 0;
+	}
+
+	// Collect equal bits
+	*pbOn = (pucData[psSource->ulIndex] >> (7 - psSource->ulBit)) & 1;
+	while((psSource->ulIndex < pucData[0]) &&
+		  (((pucData[psSource->ulIndex] >> (7 - psSource->ulBit)) & 1) == *pbOn))
+	{
+		ulRun++;
+		psSource->ulBit++;
+		if(psSource->ulBit == 8)
+		{
+			psSource->ulIndex++;
+			psSource->ulBit = 0;
+		}
+	}
+	return ulRun;
+}
+
+// Expand the glyph of ucChar to ulPixels display colors
+static void LCDGlyphExpand(const tFont *pFont, unsigned char ucChar, unsigned long ulPixels,
+						   unsigned short usForeground, unsigned short usBackground, unsigned short *pusPixels)
+{
+	tLCDGlyphSource sSource;
+	unsigned long ulRun;
+	tBoolean bOn;
+
+	LCDGlyphBegin(&sSource, pFont, ucChar);
+	while(ulPixels)
+	{
+		ulRun = LCDGlyphRun(&sSource, &bOn);
+		if(!ulRun)
+		{
+			bOn = false;
+			ulRun = ulPixels;
+		}
+		if(ulRun > ulPixels)
+		{
+			ulRun = ulPixels;
+		}
+		ulPixels -= ulRun;
+		while(ulRun--)
+		{
+			*pusPixels++ = bOn ? usForeground : usBackground;
+		}
+	}
+}
+
+// Write the next ulPixels pixels of a glyph within a burst, the rest of the last run is kept for the next call
+static void LCDGlyphStream(tLCDGlyphSource *psSource, unsigned long ulPixels,
+						   unsigned short usForeground, unsigned short usBackground)
+{
+	unsigned long ulCount;
+
+	while(ulPixels)
+	{
+		if(!psSource->ulRun)
+		{
+			psSource->ulRun = LCDGlyphRun(psSource, &psSource->bRunOn);
+			if(!psSource->ulRun)
+			{
+				// End of data, background up to the end of the glyph
+				psSource->bRunOn = false;
+				psSource->ulRun = 0xffffffff;
+			}
+		}
+
+		ulCount = (psSource->ulRun < ulPixels) ? psSource->ulRun : ulPixels;
+		LCDBurstRepeat(psSource->bRunOn ? usForeground : usBackground, ulCount);
+		psSource->ulRun -= ulCount;
+		ulPixels -= ulCount;
+	}
+}
+
+// Remove the least recently used glyph from the cache and move the glyphs behind it down
+static void LCDGlyphEvict(void)
+{
+	unsigned long ulOldest = 0, ulPixels, ulEnd, i;
+	tLCDGlyph *psGlyph;
+
+	for(i = 1; i < g_ulGlyphCount; i++)
+	{
+		if(g_ulGlyphClock - g_psGlyphs[i].ulUsed > g_ulGlyphClock - g_psGlyphs[ulOldest].ulUsed)
+		{
+			ulOldest = i;
+		}
+	}
+
+	psGlyph = &g_psGlyphs[ulOldest];
+	ulPixels = psGlyph->ucWidth * psGlyph->pFont->ucHeight;
+	for(i = psGlyph->usOffset, ulEnd = g_ulGlyphPixels - ulPixels; i < ulEnd; i++)
+	{
+		g_pusGlyphArena[i] = g_pusGlyphArena[i + ulPixels];
+	}
+	g_ulGlyphPixels -= ulPixels;
+
+	for(i = ulOldest + 1; i < g_ulGlyphCount; i++)
+	{
+		g_psGlyphs[i - 1] = g_psGlyphs[i];
+		g_psGlyphs[i - 1].usOffset -= ulPixels;
+	}
+	g_ulGlyphCount--;
+}
+
+// Return the pixels of a glyph in the given display colors from the cache, expanded into it on a miss
+// Returns 0 if the glyph is larger than the arena
+static const unsigned short *LCDGlyphGet(const tFont *pFont, unsigned char ucChar,
+										 unsigned short usForeground, unsigned short usBackground)
+{
+	unsigned long ulWidth = pFont->pucData[pFont->pusOffset[ucChar - ' '] + 1];
+	unsigned long ulPixels = ulWidth * pFont->ucHeight;
+	tLCDGlyph *psGlyph;
+	unsigned long i;
+
+	g_ulGlyphClock++;
+
+	for(i = 0; i < g_ulGlyphCount; i++)
+	{
+		psGlyph = &g_psGlyphs[i];
+		if((psGlyph->pFont == pFont) && (psGlyph->ucChar == ucChar) &&
+		   (psGlyph->usForeground == usForeground) && (psGlyph->usBackground == usBackground))
+		{
+			g_ulGlyphHits++;
+			psGlyph->ulUsed = g_ulGlyphClock;
+			return g_pusGlyphArena + psGlyph->usOffset;
+		}
+	}
+
+	g_ulGlyphMisses++;
+	if(ulPixels > LCD_GLYPH_CACHE_PIXELS)
+	{
+		return 0;
+	}
+
+	while((g_ulGlyphCount == LCD_GLYPH_CACHE_ENTRIES) || (g_ulGlyphPixels + ulPixels > LCD_GLYPH_CACHE_PIXELS))
+	{
+		LCDGlyphEvict();
+	}
+
+	psGlyph = &g_psGlyphs[g_ulGlyphCount++];
+	psGlyph->pFont = pFont;
+	psGlyph->usForeground = usForeground;
+	psGlyph->usBackground = usBackground;
+	psGlyph->ucChar = ucChar;
+	psGlyph->ucWidth = ulWidth;
+	psGlyph->usOffset = g_ulGlyphPixels;
+	psGlyph->ulUsed = g_ulGlyphClock;
+	g_ulGlyphPixels += ulPixels;
+
+	LCDGlyphExpand(pFont, ucChar, ulPixels, usForeground, usBackground, g_pusGlyphArena + psGlyph->usOffset);
+
+	return g_pusGlyphArena + psGlyph->usOffset;
+}
+
+// Write up to LCD_STRING_CELL_CHARS characters of equal width into one window, row by row across all glyphs
+// The glyphs are decoded straight from the font data. Returns false without drawing if the string is
+// longer, its glyphs differ in width or it is not fully inside the clipping region.
+static tBoolean LCDStringCell(const tContext *pContext, const char *pcString, long lLength, long lX, long lY)
+{
+	const tFont *pFont = pContext->pFont;
+	unsigned long ulChars, ulPixels, ulRow, i;
+	unsigned char ucChar;
+	tRectangle sCell;
+	long lWidth = 0;
+
+	for(ulChars = 0; (ulChars != (unsigned long)lLength) && pcString[ulChars]; ulChars++)
+	{
+		ucChar = ((pcString[ulChars] < ' ') || (pcString[ulChars] > '~')) ? '.' : pcString[ulChars];
+		if(ulChars == LCD_STRING_CELL_CHARS)
+		{
+			return false;
+		}
+		if(ulChars && (pFont->pucData[pFont->pusOffset[ucChar - ' '] + 1] != lWidth))
+		{
+			return false;
+		}
+		lWidth = pFont->pucData[pFont->pusOffset[ucChar - ' '] + 1];
+		LCDGlyphBegin(&g_psCellSources[ulChars], pFont, ucChar);
+	}
+
+	sCell.sXMin = lX;
+	sCell.sYMin = lY;
+	sCell.sXMax = lX + (long)ulChars * lWidth - 1;
+	sCell.sYMax = lY + pFont->ucHeight - 1;
+	if(!ulChars || !lWidth || (sCell.sXMin < pContext->sClipRegion.sXMin) || (sCell.sYMin < pContext->sClipRegion.sYMin) ||
+	   (sCell.sXMax > pContext->sClipRegion.sXMax) || (sCell.sYMax > pContext->sClipRegion.sYMax))
+	{
+		return false;
+	}
+	ulPixels = ulChars * lWidth * pFont->ucHeight;
+
+	// Draw queued pixels and recorded primitives first
+	LCDPixelQueueSubmit();
+	LCDDeferRender();
+
+	// Start talking to LCD
+	LCDSessionBegin();
+
+	LCDDisplayWindow(&sCell);
+
+	// Spacing between characters is part of the glyphs, so the stream is continuous
+	LCDBurstBegin();
+	for(ulRow = 0; ulRow < pFont->ucHeight; ulRow++)
+	{
+		for(i = 0; i < ulChars; i++)
+		{
+			LCDGlyphStream(&g_psCellSources[i], lWidth, pContext->ulForeground, pContext->ulBackground);
+		}
+	}
+	LCDBurstEnd(ulPixels);
+
+	// Done talking to LCD
+	LCDSessionEnd();
+
+	// Draw sprites again over new pixels
+	if(g_ulSpritesVisible)
+	{
+		LCDSpriteUpdate(sCell.sXMin, sCell.sYMin, sCell.sXMax, sCell.sYMax);
+	}
+
+	return true;
+}
+
+// Draw a string with foreground and background colors of the context like GrStringDraw with bOpaque set
+// A visible string of up to LCD_STRING_CELL_CHARS characters of equal width, e.g. a numeric readout, is
+// written into one window. Otherwise glyphs come from a cache holding them in display colors and are
+// written as one rectangle each. lLength is the number of characters to draw or -1 for the whole
+// string, characters outside the font are drawn as a period like in GrStringDraw.
+// In deferred mode and while a display list is recorded the string is drawn by grlib, so that its glyphs
+// are recorded like other primitives.
+void Adafruit320x240x16_ILI9325StringDraw(const tContext *pContext, const char *pcString, long lLength, long lX, long lY)
+{
+	const tFont *pFont = pContext->pFont;
+	const unsigned short *pusPixels;
+	const char *pcChar;
+	tRectangle sClip;
+	long lWidth;
+
+	if(g_bDefer || g_psList)
+	{
+		GrStringDraw(pContext, pcString, lLength, lX, lY, true);
+		return;
+	}
+
+	if(LCDStringCell(pContext, pcString, lLength, lX, lY))
+	{
+		return;
+	}
+
+	while(lLength-- && *pcString)
+	{
+		if(lX > pContext->sClipRegion.sXMax)
+		{
+			break;
+		}
+
+		pcChar = ((*pcString < ' ') || (*pcString > '~')) ? "." : pcString;
+		pcString++;
+		lWidth = pFont->pucData[pFont->pusOffset[*pcChar - ' '] + 1];
+
+		// Visible part of glyph
+		sClip.sXMin = (lX > pContext->sClipRegion.sXMin) ? lX : pContext->sClipRegion.sXMin;
+		sClip.sYMin = (lY > pContext->sClipRegion.sYMin) ? lY : pContext->sClipRegion.sYMin;
+		sClip.sXMax = (lX + lWidth - 1 < pContext->sClipRegion.sXMax) ? lX + lWidth - 1 : pContext->sClipRegion.sXMax;
+		sClip.sYMax = (lY + pFont->ucHeight - 1 < pContext->sClipRegion.sYMax) ?
+					  lY + pFont->ucHeight - 1 : pContext->sClipRegion.sYMax;
+		if((sClip.sXMin > sClip.sXMax) || (sClip.sYMin > sClip.sYMax))
+		{
+			lX += lWidth;
+			continue;
+		}
+
+		pusPixels = LCDGlyphGet(pFont, *pcChar, pContext->ulForeground, pContext->ulBackground);
+		if(pusPixels)
+		{
+			Adafruit320x240x16_ILI9325Blit(&sClip, pusPixels + (sClip.sYMin - lY) * lWidth + (sClip.sXMin - lX), lWidth);
+
+			// Draw sprites again over new pixels
+			if(g_ulSpritesVisible)
+			{
+				LCDSpriteUpdate(sClip.sXMin, sClip.sYMin, sClip.sXMax, sClip.sYMax);
+			}
+		}
+		else if(!LCDStringCell(pContext, pcChar, 1, lX, lY))
+		{
+			// Too large for cache and clipped
+			GrStringDraw(pContext, pcChar, 1, lX, lY, true);
+		}
+
+		lX += lWidth;
+	}
+}
+
+// Return the number of glyphs found in the cache and the number expanded since startup
+void Adafruit320x240x16_ILI9325GlyphCacheStats(unsigned long *pulHits, unsigned long *pulMisses)
+{
+	*pulHits = g_ulGlyphHits;
+	*pulMisses = g_ulGlyphMisses;
+}
+
+// Empty glyph cache, e.g. after a font in RAM was changed
+void Adafruit320x240x16_ILI9325GlyphCacheInvalidate(void)
+{
+	g_ulGlyphCount = 0;
+	g_ulGlyphPixels = 0;
+}
+
+// grlib structures describing Adafruit 320x240x16 TFT Touch Display driver in each orientation
+#define LCD_DISPLAY_PORTRAIT \
+{ \
+		sizeof(tDisplay),										/* size of this structure */ \
+		0,														/* ptr to display specific data(?) */ \
+		LCD_X,													/* width in pixel */ \
+		LCD_Y,													/* height in pixel */ \
+		Adafruit320x240x16_ILI9325PixelDrawPortrait,			/* function to draw pixel */ \
+		Adafruit320x240x16_ILI9325PixelDrawMultiplePortrait,	/* function to draw multiple pixel */ \
+		Adafruit320x240x16_ILI9325LineDrawHPortrait,			/* function to draw horizontal line */ \
+		Adafruit320x240x16_ILI9325LineDrawVPortrait,			/* function to draw vertical line */ \
+		Adafruit320x240x16_ILI9325RectFillPortrait,				/* function to fill rectangle */ \
+		Adafruit320x240x16_ILI9325ColorTranslate,				/* function to translate 24bit color */ \
+		Adafruit320x240x16_ILI9325Flush							/* function to flush display writes */ \
+}
+
+#define LCD_DISPLAY_LANDSCAPE \
+{ \
+		sizeof(tDisplay),										/* size of this structure */ \
+		0,														/* ptr to display specific data(?) */ \
+		LCD_Y,													/* width in pixel */ \
+		LCD_X,													/* height in pixel */ \
+		Adafruit320x240x16_ILI9325PixelDrawLandscape,			/* function to draw pixel */ \
+		Adafruit320x240x16_ILI9325PixelDrawMultipleLandscape,	/* function to draw multiple pixel */ \
+		Adafruit320x240x16_ILI9325LineDrawHLandscape,			/* function to draw horizontal line */ \
+		Adafruit320x240x16_ILI9325LineDrawVLandscape,			/* function to draw vertical line */ \
+		Adafruit320x240x16_ILI9325RectFillLandscape,			/* function to fill rectangle */ \
+		Adafruit320x240x16_ILI9325ColorTranslate,				/* function to translate 24bit color */ \
+		Adafruit320x240x16_ILI9325Flush							/* function to flush display writes */ \
+}
+
+const tDisplay g_sAdafruit320x240x16_ILI9325Portrait = LCD_DISPLAY_PORTRAIT;
+const tDisplay g_sAdafruit320x240x16_ILI9325Landscape = LCD_DISPLAY_LANDSCAPE;
+const tDisplay g_sAdafruit320x240x16_ILI9325PortraitFlip = LCD_DISPLAY_PORTRAIT;
+const tDisplay g_sAdafruit320x240x16_ILI9325LandscapeFlip = LCD_DISPLAY_LANDSCAPE;
+
+// Display in default orientation
+#if defined(PORTRAIT) || defined(PORTRAIT_FLIP)
+const tDisplay g_sAdafruit320x240x16_ILI9325 = LCD_DISPLAY_PORTRAIT;
+#else
+const tDisplay g_sAdafruit320x240x16_ILI9325 = LCD_DISPLAY_LANDSCAPE;
+#endif
+
+// Change orientation, returns the display structure to use with GrContextInit
+// Content of the display is not rotated and should be repainted
+const tDisplay *Adafruit320x240x16_ILI9325RotationSet(unsigned long ulRotation)
+{
+	// Draw queued pixels and recorded primitives first
+	LCDPixelQueueSubmit();
+	LCDDeferRender();
+
+	// Start talking to LCD
+	LCDSessionBegin();
+
+	g_ulRotation = ulRotation;
+	LCDScanSet();
+
+	// Content is repainted in the new orientation, start without scrolling and sprites
+	g_ulScroll = 0;
+	g_ulSpritesVisible = 0;
+	LCDWriteRegister(ILI_GATE_SCAN_CTRL3, 0);
+
+	// Done talking to LCD
+	LCDSessionEnd();
+
+	switch(ulRotation)
+	{
+	case ADAFRUIT_ILI9325_PORTRAIT:			return &g_sAdafruit320x240x16_ILI9325Portrait;
+	case ADAFRUIT_ILI9325_PORTRAIT_FLIP:	return &g_sAdafruit320x240x16_ILI9325PortraitFlip;
+	case ADAFRUIT_ILI9325_LANDSCAPE_FLIP:	return &g_sAdafruit320x240x16_ILI9325LandscapeFlip;
+	default:								return &g_sAdafruit320x240x16_ILI9325Landscape;
+	}
+}
+
+// Scroll the display content by ulLines along the 320 line axis, the vertical axis in portrait
+// and the horizontal axis in landscape orientations. The controller scrolls the whole GRAM in
+// a ring, the first line on screen shows GRAM line ulLines and lines wrap around at 320.
+// Drawing coordinates are not affected and keep addressing GRAM, e.g. in portrait the line
+// drawn at Y is shown at screen line (Y - ulLines) modulo 320.
+void Adafruit320x240x16_ILI9325ScrollSet(unsigned long ulLines)
+{
+	g_ulScroll = ulLines % LCD_Y;
+
+	// Start talking to LCD
+	LCDSessionBegin();
+
+	LCDWriteRegister(ILI_GATE_SCAN_CTRL3, g_ulScroll);		// Vertical Scroll Control (R6Ah)
+
+	// Done talking to LCD
+	LCDSessionEnd();
+}
+
+// Return current hardware scroll offset in lines
+unsigned long Adafruit320x240x16_ILI9325ScrollGet(void)
+{
+	return g_ulScroll;
+}
+
+// Show GRAM lines ulFirst to ulLast at screen line ulPosition as partial image 0 or 1
+// Lines are counted along the 320 line axis like for Adafruit320x240x16_ILI9325ScrollSet, i.e. rows
+// in portrait and columns in landscape orientations, and are the same as drawing coordinates on
+// that axis. Partial images are not moved by the scroll offset, e.g. a status bar drawn at lines
+// 0 to 19 stays in place with Adafruit320x240x16_ILI9325PartialSet(0, 0, 0, 19).
+void Adafruit320x240x16_ILI9325PartialSet(unsigned long ulImage, unsigned long ulPosition,
+										  unsigned long ulFirst, unsigned long ulLast)
+{
+	unsigned char ucRegister = ulImage ? ILI_PART_IMG2_DISP_POS : ILI_PART_IMG1_DISP_POS;
+
+	// Start talking to LCD
+	LCDSessionBegin();
+
+	LCDWriteRegister(ucRegister, ulPosition);		// Partial Image Display Position (R80h/R83h)
+	LCDWriteRegister(ucRegister + 1, ulFirst);		// Partial Image Area Start Line (R81h/R84h)
+	LCDWriteRegister(ucRegister + 2, ulLast);		// Partial Image Area End Line (R82h/R85h)
+
+	g_usDisplayControl |= ulImage ? ILI_DISP_CTRL1_PTDE1 : ILI_DISP_CTRL1_PTDE0;
+	LCDWriteRegister(ILI_DISP_CTRL1, g_usDisplayControl);
+
+	// Done talking to LCD
+	LCDSessionEnd();
+}
+
+// Stop showing partial image 0 or 1
+void Adafruit320x240x16_ILI9325PartialDisable(unsigned long ulImage)
+{
+	// Start talking to LCD
+	LCDSessionBegin();
+
+	g_usDisplayControl &= ~(ulImage ? ILI_DISP_CTRL1_PTDE1 : ILI_DISP_CTRL1_PTDE0);
+	LCDWriteRegister(ILI_DISP_CTRL1, g_usDisplayControl);
+
+	// Done talking to LCD
+	LCDSessionEnd();
+}
+
+// Turn display of the base image on or off, when off only partial images are shown
+void Adafruit320x240x16_ILI9325BaseImageEnable(tBoolean bEnable)
+{
+	// Start talking to LCD
+	LCDSessionBegin();
+
+	if(bEnable)
+	{
+		g_usDisplayControl |= ILI_DISP_CTRL1_BASEE;
+	}
+	else
+	{
+		g_usDisplayControl &= ~ILI_DISP_CTRL1_BASEE;
+	}
+	LCDWriteRegister(ILI_DISP_CTRL1, g_usDisplayControl);
+
+	// Done talking to LCD
+	LCDSessionEnd();
+}
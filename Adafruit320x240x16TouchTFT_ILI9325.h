@@ -29,8 +29,89 @@
 #ifndef ADAFRUIT320X240X16TOUCHTFT_ILI9325_H_
 #define ADAFRUIT320X240X16TOUCHTFT_ILI9325_H_
 
+// Orientations for Adafruit320x240x16_ILI9325RotationSet, rotated counter-clockwise
+#define ADAFRUIT_ILI9325_PORTRAIT		0	// 0 degrees
+#define ADAFRUIT_ILI9325_LANDSCAPE		1	// 90 degrees
+#define ADAFRUIT_ILI9325_PORTRAIT_FLIP	2	// 180 degrees
+#define ADAFRUIT_ILI9325_LANDSCAPE_FLIP	3	// 270 degrees
+
+// Bus image format for Adafruit320x240x16_ILI9325BusImageDraw, created by tools/ili9325img.py
+// Header is the format byte, width and height as 16 bit little endian values, followed by records
+// of a 16 bit big endian word with the run flag and the number of pixels - 1. A run record holds
+// one color, a literal record all its pixels, each as high byte then low byte of RGB565.
+#define ADAFRUIT_ILI9325_BUSIMAGE		0x10	// format byte
+#define ADAFRUIT_ILI9325_BUSIMAGE_RUN	0x8000	// record is a run of one color
+#define ADAFRUIT_ILI9325_BUSIMAGE_COUNT	0x7FFF	// number of pixels - 1 in record
+
+// Called by Adafruit320x240x16_ILI9325InitTick once the display is ready
+typedef void (*tILI9325InitCallback)(void);
+
+// Sprite image for Adafruit320x240x16_ILI9325SpriteShow
+typedef struct
+{
+	unsigned short usWidth;				// size in pixels
+	unsigned short usHeight;
+	const unsigned short *pusPixels;	// RGB565 pixels, row by row
+	const unsigned char *pucMask;		// 1 bpp mask, 1 for opaque pixels, most significant bit first and rows padded to bytes
+										// or 0 to use the color key
+	unsigned short usKey;				// color of transparent pixels if there is no mask
+} tILI9325Sprite;
+
+// Bytes of the tile buffer for Adafruit320x240x16_ILI9325DeferBegin holding ulPixels pixels, a multiple of 32
+// Blit and BusImageDraw are not recorded in deferred mode, use them between frames
+#define ADAFRUIT_ILI9325_TILE_BYTES(ulPixels)	((ulPixels) / 32 * 68)
+
+// Display list recorded by Adafruit320x240x16_ILI9325ListBegin into an arena of the caller
+// Blit and BusImageDraw are not recorded and must not be used while a list is recorded
+typedef struct
+{
+	unsigned long *pulArena;			// records
+	unsigned long ulWords;				// size of arena in words
+	unsigned long ulUsed;				// words used by records
+	tBoolean bOverflow;					// a primitive did not fit, list is incomplete
+} tILI9325List;
+
 // Declarations of variables and functions exported by driver
 extern void Adafruit320x240x16_ILI9325Init(void);
+extern void Adafruit320x240x16_ILI9325InitStart(tILI9325InitCallback pfnDone);
+extern tBoolean Adafruit320x240x16_ILI9325InitTick(unsigned long ulMs);
+extern tBoolean Adafruit320x240x16_ILI9325InitDone(void);
+extern void Adafruit320x240x16_ILI9325CacheInvalidate(void);
+extern void Adafruit320x240x16_ILI9325PaletteInvalidate(const unsigned char *pucPalette);
+extern void Adafruit320x240x16_ILI9325BatchBegin(unsigned long ulMaxOps);
+extern void Adafruit320x240x16_ILI9325BatchEnd(void);
+extern void Adafruit320x240x16_ILI9325DeferBegin(unsigned long *pulTile, unsigned long ulTileBytes,
+												 unsigned long *pulList, unsigned long ulListBytes);
+extern void Adafruit320x240x16_ILI9325DeferEnd(void);
+extern void Adafruit320x240x16_ILI9325ListBegin(tILI9325List *psList, unsigned long *pulArena, unsigned long ulBytes);
+extern tBoolean Adafruit320x240x16_ILI9325ListEnd(void);
+extern void Adafruit320x240x16_ILI9325ListReplay(const tILI9325List *psList);
+extern void Adafruit320x240x16_ILI9325ListReplayChanged(const tILI9325List *psList, const tILI9325List *psPrevious);
+// PixelDrawMultiple of these displays reads all 16 or 256 palette entries of 4 and 8 bpp data,
+// palettes passed to DpyPixelDrawMultiple must be that large
 extern const tDisplay g_sAdafruit320x240x16_ILI9325;
+extern const tDisplay g_sAdafruit320x240x16_ILI9325Portrait;
+extern const tDisplay g_sAdafruit320x240x16_ILI9325Landscape;
+extern const tDisplay g_sAdafruit320x240x16_ILI9325PortraitFlip;
+extern const tDisplay g_sAdafruit320x240x16_ILI9325LandscapeFlip;
+extern const tDisplay *Adafruit320x240x16_ILI9325RotationSet(unsigned long ulRotation);
+extern void Adafruit320x240x16_ILI9325Blit(const tRectangle *pRect, const unsigned short *pusData, long lStride);
+extern void Adafruit320x240x16_ILI9325ImageDraw(const tContext *pContext, const unsigned char *pucImage, long lX, long lY);
+extern void Adafruit320x240x16_ILI9325BusImageDraw(const unsigned char *pucImage, long lX, long lY);
+extern void Adafruit320x240x16_ILI9325StringDraw(const tContext *pContext, const char *pcString, long lLength, long lX, long lY);
+extern void Adafruit320x240x16_ILI9325GlyphCacheStats(unsigned long *pulHits, unsigned long *pulMisses);
+extern void Adafruit320x240x16_ILI9325GlyphCacheInvalidate(void);
+extern void Adafruit320x240x16_ILI9325ScrollSet(unsigned long ulLines);
+extern unsigned long Adafruit320x240x16_ILI9325ScrollGet(void);
+extern void Adafruit320x240x16_ILI9325PartialSet(unsigned long ulImage, unsigned long ulPosition,
+												 unsigned long ulFirst, unsigned long ulLast);
+extern void Adafruit320x240x16_ILI9325PartialDisable(unsigned long ulImage);
+extern void Adafruit320x240x16_ILI9325BaseImageEnable(tBoolean bEnable);
+extern void Adafruit320x240x16_ILI9325RectRead(const tRectangle *pRect, unsigned short *pusData, long lStride);
+extern unsigned short Adafruit320x240x16_ILI9325PixelRead(long lX, long lY);
+extern unsigned short Adafruit320x240x16_ILI9325RegisterRead(unsigned char ucAddress);
+extern void Adafruit320x240x16_ILI9325RectCopy(const tRectangle *pSrc, long lX, long lY);
+extern tBoolean Adafruit320x240x16_ILI9325SpriteShow(unsigned long ulSprite, const tILI9325Sprite *psImage, long lX, long lY);
+extern void Adafruit320x240x16_ILI9325SpriteHide(unsigned long ulSprite);
 
 #endif /* ADAFRUIT320X240X16TOUCHTFT_ILI9325_H_ */
@@ -0,0 +1,122 @@
+//
+// console.c
+//
+// Scrolling text console on top of the hardware scrolling of the
+// Adafruit 320x240 16 bit color touch TFT driver
+//
+
+#include "inc/hw_types.h"
+#include "grlib/grlib.h"
+#include "Adafruit320x240x16TouchTFT_ILI9325.h"
+#include "console.h"
+
+// The console appends text lines at the bottom of the screen. Once the screen is full, the controller
+// scrolls the display by one text line and only the newly exposed line is drawn, into the GRAM lines
+// that just left the top of the screen. A line may wrap from the last to the first GRAM line, in which
+// case it is drawn in two parts.
+// Hardware scrolling moves the display along its 320 line axis, so the console is only useful in the
+// portrait orientations. Other drawing in the console area has to take the scroll offset into account,
+// see Adafruit320x240x16_ILI9325ScrollSet.
+
+// Draw part of a text line, clipped to the GRAM lines lY1 to lY2
+// The text starts at line lY, which may be outside of the part.
+static void ConsolePartDraw(tConsole *psConsole, const char *pcText, long lLength, long lY, long lY1, long lY2)
+{
+	tRectangle sRect;
+	unsigned long ulForeground;
+
+	sRect.sXMin = psConsole->lXMin;
+	sRect.sYMin = lY1;
+	sRect.sXMax = psConsole->lXMax;
+	sRect.sYMax = lY2;
+	psConsole->sContext.sClipRegion = sRect;
+
+	// Clear the whole width of the line, colors of the context are already translated and can be swapped
+	ulForeground = psConsole->sContext.ulForeground;
+	psConsole->sContext.ulForeground = psConsole->sContext.ulBackground;
+	GrRectFill(&psConsole->sContext, &sRect);
+	psConsole->sContext.ulForeground = ulForeground;
+
+	// Draw the text on the cleared line
+	if(lLength)
+	{
+		GrStringDraw(&psConsole->sContext, pcText, lLength, psConsole->lXMin, lY, 0);
+	}
+}
+
+// Append a line of lLength characters at the bottom of the console, scrolling the display if the screen is full
+static void ConsoleLineDraw(tConsole *psConsole, const char *pcText, long lLength)
+{
+	// The new line starts after the last one, in GRAM lines
+	long lY = (psConsole->lTop + psConsole->lUsed) % psConsole->lRing;
+
+	// Scroll the display so the new line ends at the bottom of the screen
+	if(psConsole->lUsed + psConsole->lLineHeight > psConsole->lRing)
+	{
+		psConsole->lTop = (psConsole->lTop + psConsole->lUsed + psConsole->lLineHeight - psConsole->lRing) %
+						  psConsole->lRing;
+		psConsole->lUsed = psConsole->lRing;
+		Adafruit320x240x16_ILI9325ScrollSet(psConsole->lTop);
+	}
+	else
+	{
+		psConsole->lUsed += psConsole->lLineHeight;
+	}
+
+	// Draw the line, in two parts if it wraps at the end of the GRAM
+	if(lY + psConsole->lLineHeight <= psConsole->lRing)
+	{
+		ConsolePartDraw(psConsole, pcText, lLength, lY, lY, lY + psConsole->lLineHeight - 1);
+	}
+	else
+	{
+		ConsolePartDraw(psConsole, pcText, lLength, lY, lY, psConsole->lRing - 1);
+		ConsolePartDraw(psConsole, pcText, lLength, lY - psConsole->lRing, 0,
+						lY + psConsole->lLineHeight - psConsole->lRing - 1);
+	}
+}
+
+// Initialize a console drawing with pContext, its font and colors are used for the text and the
+// columns of its clipping region for the console. The console area is cleared and the scroll offset reset.
+void ConsoleInit(tConsole *psConsole, const tContext *pContext)
+{
+	psConsole->sContext = *pContext;
+	psConsole->lXMin = pContext->sClipRegion.sXMin;
+	psConsole->lXMax = pContext->sClipRegion.sXMax;
+	psConsole->lLineHeight = GrFontHeightGet(pContext->pFont);
+	psConsole->lRing = GrContextDpyHeightGet(pContext);
+
+	ConsoleClear(psConsole);
+}
+
+// Clear console and reset the scroll offset
+void ConsoleClear(tConsole *psConsole)
+{
+	psConsole->lTop = 0;
+	psConsole->lUsed = 0;
+	Adafruit320x240x16_ILI9325ScrollSet(0);
+
+	ConsolePartDraw(psConsole, "", 0, 0, 0, psConsole->lRing - 1);
+}
+
+// Print text on a console, every line of the text separated by new line characters is appended at
+// the bottom of the console. Lines longer than the console are cut off.
+void ConsolePrint(tConsole *psConsole, const char *pcText)
+{
+	long lLength;
+
+	while(1)
+	{
+		for(lLength = 0; pcText[lLength] && (pcText[lLength] != '\n'); lLength++)
+		{
+		}
+
+		ConsoleLineDraw(psConsole, pcText, lLength);
+
+		if(!pcText[lLength])
+		{
+			break;
+		}
+		pcText += lLength + 1;
+	}
+}
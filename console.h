@@ -0,0 +1,29 @@
+//
+// console.h
+//
+// Scrolling text console on top of the hardware scrolling of the
+// Adafruit 320x240 16 bit color touch TFT driver
+//
+
+#ifndef CONSOLE_H_
+#define CONSOLE_H_
+
+// State of a console, it uses the columns of the clipping region of the context it was initialized
+// with and all 320 lines of the display, which are scrolled as a ring by the controller
+typedef struct
+{
+	tContext sContext;					// copy of context, the clipping region is changed for every line
+	long lXMin;							// first and last column used by the console
+	long lXMax;
+	long lLineHeight;					// height of a text line
+	long lRing;							// number of display lines in the ring
+	long lTop;							// GRAM line shown at the top of the screen
+	long lUsed;							// lines from there to the end of the last text line
+} tConsole;
+
+// Declarations of functions exported by console
+extern void ConsoleInit(tConsole *psConsole, const tContext *pContext);
+extern void ConsoleClear(tConsole *psConsole);
+extern void ConsolePrint(tConsole *psConsole, const char *pcText);
+
+#endif /* CONSOLE_H_ */
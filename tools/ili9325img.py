@@ -0,0 +1,218 @@
+#!/usr/bin/env python3
+#
+# ili9325img.py
+#
+# Converts PPM or PNG images into C arrays in the bus image format of the
+# Adafruit 320x240x16 TFT driver, drawn by Adafruit320x240x16_ILI9325BusImageDraw
+#
+# Copyright (c) 2012, Adrian Studer
+# All rights reserved.
+#
+# License: (MIT License), see Adafruit320x240x16TouchTFT_ILI9325.c
+#
+# Usage: ili9325img.py [-n name] [-o output.c] image.ppm|image.png
+#
+# Pixels are stored as RGB565 split into high and low byte, in the order they are
+# sent on the bus. Consecutive pixels of one color become run records, all other
+# pixels are collected into literal records. See ADAFRUIT_ILI9325_BUSIMAGE in
+# Adafruit320x240x16TouchTFT_ILI9325.h for the layout.
+#
+
+import os
+import re
+import struct
+import sys
+import zlib
+
+BUSIMAGE = 0x10         # format byte
+BUSIMAGE_RUN = 0x8000   # record is a run of one color
+BUSIMAGE_COUNT = 0x7FFF # number of pixels - 1 in record
+RUN_MIN = 3             # shortest run stored as run record
+
+
+def read_ppm(data):
+    # Binary (P6) or ASCII (P3) portable pixmap, returns width, height and rows of (r, g, b)
+    tokens = []
+    pos = 0
+    while len(tokens) < 4:
+        match = re.compile(rb'\s*(#[^\n]*\n\s*)*(\S+)').match(data, pos)
+        if not match:
+            raise ValueError('truncated PPM header')
+        tokens.append(match.group(2))
+        pos = match.end()
+    magic, width, height, maxval = tokens[0], int(tokens[1]), int(tokens[2]), int(tokens[3])
+
+    if magic == b'P6':
+        pos += 1
+        size = 2 if maxval > 255 else 1
+        values = []
+        for i in range(width * height * 3):
+            if size == 2:
+                values.append((data[pos] << 8) | data[pos + 1])
+            else:
+                values.append(data[pos])
+            pos += size
+    elif magic == b'P3':
+        values = [int(v) for v in data[pos:].split()[:width * height * 3]]
+    else:
+        raise ValueError('only P3 and P6 PPM files are supported')
+
+    values = [v * 255 // maxval for v in values]
+    rows = []
+    for y in range(height):
+        row = values[y * width * 3:(y + 1) * width * 3]
+        rows.append([tuple(row[x * 3:x * 3 + 3]) for x in range(width)])
+    return width, height, rows
+
+
+def read_png(data):
+    # Non-interlaced PNG of any color type, returns width, height and rows of (r, g, b)
+    pos = 8
+    idat = b''
+    palette = []
+    while pos < len(data):
+        length, kind = struct.unpack('>I4s', data[pos:pos + 8])
+        chunk = data[pos + 8:pos + 8 + length]
+        pos += 12 + length
+        if kind == b'IHDR':
+            width, height, depth, ctype, _, _, interlace = struct.unpack('>IIBBBBB', chunk)
+        elif kind == b'PLTE':
+            palette = [tuple(chunk[i:i + 3]) for i in range(0, len(chunk), 3)]
+        elif kind == b'IDAT':
+            idat += chunk
+        elif kind == b'IEND':
+            break
+    if interlace:
+        raise ValueError('interlaced PNG files are not supported')
+
+    channels = {0: 1, 2: 3, 3: 1, 4: 2, 6: 4}[ctype]
+    bits = channels * depth
+    stride = (width * bits + 7) // 8
+    step = max(1, bits // 8)
+    raw = zlib.decompress(idat)
+
+    rows = []
+    prev = bytearray(stride)
+    for y in range(height):
+        filt = raw[y * (stride + 1)]
+        line = bytearray(raw[y * (stride + 1) + 1:(y + 1) * (stride + 1)])
+        for i in range(stride):
+            a = line[i - step] if i >= step else 0
+            b = prev[i]
+            c = prev[i - step] if i >= step else 0
+            if filt == 1:
+                line[i] = (line[i] + a) & 0xff
+            elif filt == 2:
+                line[i] = (line[i] + b) & 0xff
+            elif filt == 3:
+                line[i] = (line[i] + ((a + b) >> 1)) & 0xff
+            elif filt == 4:
+                p = a + b - c
+                pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+                line[i] = (line[i] + (a if pa <= pb and pa <= pc else b if pb <= pc else c)) & 0xff
+        prev = line
+
+        # Split line into samples, scaled to 8 bit
+        samples = []
+        if depth < 8:
+            for i in range(width * channels):
+                samples.append((line[i * depth // 8] >> (8 - depth - (i * depth) % 8)) & ((1 << depth) - 1))
+        else:
+            size = depth // 8
+            for i in range(width * channels):
+                samples.append(line[i * size])
+        if ctype != 3 and depth < 8:
+            samples = [s * 255 // ((1 << depth) - 1) for s in samples]
+
+        row = []
+        for x in range(width):
+            pixel = samples[x * channels:(x + 1) * channels]
+            if ctype == 3:
+                row.append(palette[pixel[0]])
+            elif ctype in (0, 4):
+                row.append((pixel[0], pixel[0], pixel[0]))
+            else:
+                row.append(tuple(pixel[0:3]))
+        rows.append(row)
+    return width, height, rows
+
+
+def encode(width, height, rows):
+    # Returns the bus image as bytes
+    pixels = []
+    for row in rows:
+        for r, g, b in row:
+            pixels.append(((r & 0xf8) << 8) | ((g & 0xfc) << 3) | (b >> 3))
+
+    out = bytearray([BUSIMAGE, width & 0xff, width >> 8, height & 0xff, height >> 8])
+    literal = []
+
+    def flush_literal():
+        while literal:
+            part = literal[:BUSIMAGE_COUNT + 1]
+            del literal[:BUSIMAGE_COUNT + 1]
+            out.extend(struct.pack('>H', len(part) - 1))
+            for color in part:
+                out.extend(struct.pack('>H', color))
+
+    i = 0
+    while i < len(pixels):
+        run = 1
+        while i + run < len(pixels) and pixels[i + run] == pixels[i] and run <= BUSIMAGE_COUNT:
+            run += 1
+        if run >= RUN_MIN:
+            flush_literal()
+            out.extend(struct.pack('>HH', BUSIMAGE_RUN | (run - 1), pixels[i]))
+        else:
+            literal.extend(pixels[i:i + run])
+        i += run
+    flush_literal()
+    return bytes(out)
+
+
+def main(argv):
+    name = None
+    output = None
+    args = argv[1:]
+    while len(args) > 1:
+        if args[0] == '-n':
+            name = args[1]
+        elif args[0] == '-o':
+            output = args[1]
+        else:
+            break
+        args = args[2:]
+    if len(args) != 1:
+        sys.stderr.write('Usage: ili9325img.py [-n name] [-o output.c] image.ppm|image.png\n')
+        return 1
+
+    with open(args[0], 'rb') as f:
+        data = f.read()
+    if data[:8] == b'\x89PNG\r\n\x1a\n':
+        width, height, rows = read_png(data)
+    else:
+        width, height, rows = read_ppm(data)
+    image = encode(width, height, rows)
+
+    if name is None:
+        base = os.path.splitext(os.path.basename(args[0]))[0]
+        name = 'g_puc' + ''.join(part.capitalize() for part in re.split(r'[^A-Za-z0-9]+', base) if part)
+
+    text = '// %s, %d x %d pixels, %d bytes\n' % (os.path.basename(args[0]), width, height, len(image))
+    text += 'const unsigned char %s[] =\n{\n' % name
+    text += '    0x%02x, %d, %d, %d, %d,\n' % tuple(image[0:5])
+    body = image[5:]
+    for i in range(0, len(body), 12):
+        text += '    ' + ' '.join('0x%02x,' % b for b in body[i:i + 12]) + '\n'
+    text += '};\n'
+
+    if output:
+        with open(output, 'w') as f:
+            f.write(text)
+    else:
+        sys.stdout.write(text)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))